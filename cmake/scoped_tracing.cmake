@@ -0,0 +1,23 @@
+# Copyright (c) 2025 by Cliff Green
+#
+# Optional scoped tracing for the example programs (see examples/common/scoped_trace.hpp).
+# TRACE_SCOPE is compiled in only when EXAMPLES_ENABLE_TRACING is on; a test run then
+# writes a Chrome trace file if the SCOPED_TRACE_FILE environment variable is set.
+#
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+option ( EXAMPLES_ENABLE_TRACING "Compile in TRACE_SCOPE instrumentation" OFF )
+
+# the directory of this file, captured here since a function sees its caller's directory
+set ( SCOPED_TRACE_INCLUDE_DIR ${CMAKE_CURRENT_LIST_DIR}/../examples/common )
+
+# adds examples/common to the include path (scoped_trace.hpp, and the other headers
+# shared between the examples, such as batch_kernels.hpp), and turns tracing on if
+# EXAMPLES_ENABLE_TRACING is set
+function ( add_scoped_tracing target )
+  target_include_directories ( ${target} PRIVATE ${SCOPED_TRACE_INCLUDE_DIR} )
+  if ( EXAMPLES_ENABLE_TRACING )
+    target_compile_definitions ( ${target} PRIVATE SCOPED_TRACE_ENABLED )
+  endif ()
+endfunction ()
@@ -0,0 +1,225 @@
+/** @file
+ *
+ * @brief Batch add_div_by_3, add_sub_div and square over spans, with run time ISA dispatch.
+ *
+ * Each batch kernel is one plain loop, compiled several times with different
+ * target attributes (baseline, SSE4.2, AVX2, AVX-512), so the compiler can
+ * vectorize each copy for that instruction set. The best level the CPU supports
+ * is found once (cpuid, through @c __builtin_cpu_supports) and every call goes
+ * through a small table indexed by the active level. A lower level can be forced,
+ * so that every variant can be tested against the scalar code on one machine.
+ *
+ * Target attributes are a GCC / Clang extension on x86; elsewhere (MSVC, ARM)
+ * only the baseline level exists and every table entry is the baseline loop.
+ *
+ * The kernels are shared by the intro_generic_programming examples (the span
+ * versions of the slide 17 and 18 function templates) and the
+ * unit_test_with_catch2 examples (the batch square and the ISA level tests).
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2025 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef BATCH_KERNELS_HPP_INCLUDED
+#define BATCH_KERNELS_HPP_INCLUDED
+
+#include <cstddef> // std::size_t
+#include <cstdint>
+#include <type_traits>
+#include <array>
+#include <atomic>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+#include "scoped_trace.hpp" // TRACE_SCOPE
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ISA_DISPATCH_X86
+#endif
+
+namespace isa {
+
+enum class level : int { base = 0, sse42, avx2, avx512 };
+constexpr std::size_t num_levels { 4u };
+
+constexpr std::string_view name (level lvl) {
+  constexpr std::array<std::string_view, num_levels> names { "base", "sse4.2", "avx2", "avx512" };
+  return names[static_cast<std::size_t>(lvl)];
+}
+
+inline level detect () {
+#if defined(ISA_DISPATCH_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) { return level::avx512; }
+  if (__builtin_cpu_supports("avx2")) { return level::avx2; }
+  if (__builtin_cpu_supports("sse4.2")) { return level::sse42; }
+#endif
+  return level::base;
+}
+
+inline level detected () {
+  static const level lvl { detect() };
+  return lvl;
+}
+
+inline std::atomic<int> forced_level { -1 };
+
+inline level active () {
+  int f = forced_level.load(std::memory_order_relaxed);
+  return f < 0 ? detected() : static_cast<level>(f);
+}
+
+// a level above what the CPU supports would crash with an illegal instruction
+inline void force (level lvl) {
+  if (lvl > detected()) {
+    throw std::range_error("ISA level not supported by this CPU");
+  }
+  forced_level.store(static_cast<int>(lvl), std::memory_order_relaxed);
+}
+
+inline void clear_force () { forced_level.store(-1, std::memory_order_relaxed); }
+
+// forces a level for the lifetime of the guard
+class force_guard {
+public:
+  explicit force_guard (level lvl) { force(lvl); }
+  ~force_guard () { clear_force(); }
+  force_guard (const force_guard&) = delete;
+  force_guard& operator= (const force_guard&) = delete;
+};
+
+} // end namespace
+
+namespace batch {
+
+struct square_op { // square is unary, it is called with the same span for a and b
+  auto operator() (auto x, auto) const { return x * x; }
+};
+// For 32 bit integers the division by 3 is a multiply by 1/3 in fixed point (the
+// high half of a 32 x 32 -> 64 bit product) and a shift, plus one for negative sums
+// so that the result is truncated toward zero like the division. This is what an
+// optimizing compiler turns the division into (each kernel below vectorizes it,
+// e.g. as vpmuldq for AVX2); it is written out so that no build depends on that.
+struct add_div_by_3_op {
+  template <typename T>
+  T operator() (T x, T y) const {
+    if constexpr (std::is_same_v<T, std::int32_t>) {
+      std::int32_t n = x + y;
+      return static_cast<std::int32_t>((static_cast<std::int64_t>(n) * 0x5555'5556) >> 32) - (n >> 31);
+    }
+    else if constexpr (std::is_same_v<T, std::uint32_t>) {
+      std::uint32_t n = x + y;
+      return static_cast<std::uint32_t>((static_cast<std::uint64_t>(n) * 0xAAAA'AAABu) >> 33);
+    }
+    else {
+      return static_cast<T>((x + y) / T(3));
+    }
+  }
+};
+// There is no vector integer divide, so for 32 bit integers the division is done in
+// double, which vectorizes: both operands are exact in a double, and the quotient
+// rounded to double never crosses an integer, so truncating it gives exactly the
+// integer quotient (the same method std::experimental::simd uses for int lanes).
+struct add_sub_div_op {
+  template <typename T>
+  T operator() (T x, T y) const {
+    if constexpr (std::is_same_v<T, std::int32_t> || std::is_same_v<T, std::uint32_t>) {
+      return static_cast<T>(static_cast<double>(static_cast<T>(x + y)) / static_cast<double>(static_cast<T>(x - y)));
+    }
+    else {
+      return static_cast<T>((x + y) / (x - y));
+    }
+  }
+};
+
+namespace detail {
+
+template <typename T>
+using kernel_fn = void (*)(const T*, const T*, T*, std::size_t);
+
+// The inner loop has a fixed trip count and the pointers are restrict, which is
+// what lets the compiler vectorize it at -O2 (GCC's cheap cost model at -O2 does
+// not vectorize loops that need a scalar remainder or a run time alias check).
+// Two restrict pointers to the same (unmodified) input are fine, but out must not
+// overlap a or b.
+constexpr std::size_t block_sz { 64u };
+
+template <typename Op, typename T>
+#if defined(__GNUC__)
+[[gnu::always_inline]]
+#endif
+inline void loop (const T* __restrict a, const T* __restrict b, T* __restrict out, std::size_t n) {
+  std::size_t i {0};
+  for (; (i + block_sz) <= n; i += block_sz) {
+    for (std::size_t j {0}; j < block_sz; ++j) {
+      out[i + j] = Op{}(a[i + j], b[i + j]);
+    }
+  }
+  for (; i < n; ++i) {
+    out[i] = Op{}(a[i], b[i]);
+  }
+}
+
+template <typename Op, typename T>
+void kernel_base (const T* a, const T* b, T* out, std::size_t n) { loop<Op>(a, b, out, n); }
+
+#if defined(ISA_DISPATCH_X86)
+template <typename Op, typename T>
+[[gnu::target("sse4.2")]] void kernel_sse42 (const T* a, const T* b, T* out, std::size_t n) {
+  loop<Op>(a, b, out, n);
+}
+template <typename Op, typename T>
+[[gnu::target("avx2")]] void kernel_avx2 (const T* a, const T* b, T* out, std::size_t n) {
+  loop<Op>(a, b, out, n);
+}
+template <typename Op, typename T>
+[[gnu::target("avx512f")]] void kernel_avx512 (const T* a, const T* b, T* out, std::size_t n) {
+  loop<Op>(a, b, out, n);
+}
+
+template <typename Op, typename T>
+constexpr std::array<kernel_fn<T>, isa::num_levels> kernels {
+  &kernel_base<Op, T>, &kernel_sse42<Op, T>, &kernel_avx2<Op, T>, &kernel_avx512<Op, T>
+};
+#else
+template <typename Op, typename T>
+constexpr std::array<kernel_fn<T>, isa::num_levels> kernels {
+  &kernel_base<Op, T>, &kernel_base<Op, T>, &kernel_base<Op, T>, &kernel_base<Op, T>
+};
+#endif
+
+template <typename Op, typename T>
+void dispatch (std::span<const T> a, std::span<const T> b, std::span<T> out) {
+  if (a.size() != b.size() || a.size() != out.size()) {
+    throw std::range_error("batch span sizes differ");
+  }
+  TRACE_SCOPE("batch::dispatch");
+  kernels<Op, T>[static_cast<std::size_t>(isa::active())](a.data(), b.data(), out.data(), out.size());
+}
+
+} // end namespace
+
+template <typename T>
+void square (std::span<const T> in, std::span<T> out) {
+  detail::dispatch<square_op, T>(in, in, out);
+}
+
+template <typename T>
+void add_div_by_3 (std::span<const T> a, std::span<const T> b, std::span<T> out) {
+  detail::dispatch<add_div_by_3_op, T>(a, b, out);
+}
+
+template <typename T>
+void add_sub_div (std::span<const T> a, std::span<const T> b, std::span<T> out) {
+  detail::dispatch<add_sub_div_op, T>(a, b, out);
+}
+
+} // end namespace
+
+#endif
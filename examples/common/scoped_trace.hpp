@@ -0,0 +1,304 @@
+/** @file
+ *
+ * @brief Header only scoped tracing, written out as a Chrome trace_event JSON file.
+ *
+ * @c TRACE_SCOPE("name") at the top of a block records when the block was entered
+ * and left. Each thread appends its events to its own fixed size buffer, so
+ * recording takes no lock (a lock is taken once per thread, when its buffer is
+ * created, and once more when the thread exits). @c scoped_trace::write_chrome_trace writes everything recorded so far
+ * in the JSON format understood by chrome://tracing and https://ui.perfetto.dev.
+ *
+ * Tracing is compiled in only when @c SCOPED_TRACE_ENABLED is defined (the example
+ * CMake files define it when @c EXAMPLES_ENABLE_TRACING is on). Otherwise
+ * @c TRACE_SCOPE expands to nothing, so instrumented code is exactly the code
+ * without it.
+ *
+ * Timestamps come from the CPU time stamp counter (@c rdtsc) on x86, which is
+ * cheaper to read than @c std::chrono::steady_clock, and are converted to time on
+ * export. Define @c SCOPED_TRACE_STEADY_CLOCK to always use @c steady_clock (e.g.
+ * on a CPU without an invariant TSC).
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2025 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef SCOPED_TRACE_HPP_INCLUDED
+#define SCOPED_TRACE_HPP_INCLUDED
+
+#include <cstdint>
+#include <cstddef> // std::size_t
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <memory> // std::unique_ptr, std::shared_ptr
+#include <new> // std::nothrow
+#include <array>
+#include <vector>
+#include <ostream>
+#include <ios> // std::fixed
+#include <iomanip> // std::setprecision
+#include <fstream>
+#include <string>
+#include <utility> // std::move
+
+#if !defined(SCOPED_TRACE_STEADY_CLOCK)
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h> // __rdtsc
+#define SCOPED_TRACE_RDTSC
+#elif (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <x86intrin.h> // __rdtsc
+#define SCOPED_TRACE_RDTSC
+#endif
+#endif
+
+namespace scoped_trace {
+
+inline std::uint64_t ticks () noexcept {
+#if defined(SCOPED_TRACE_RDTSC)
+  return __rdtsc();
+#else
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// name must outlive the export, e.g. a string literal
+struct event {
+  const char* name;
+  std::uint64_t start;
+  std::uint64_t end;
+};
+
+constexpr std::size_t events_per_chunk { 4096u }; // 96 KB
+constexpr std::size_t max_chunks_per_thread { 64u };
+constexpr std::size_t max_events_per_thread { events_per_chunk * max_chunks_per_thread };
+
+// Written by one thread only. Events go into chunks allocated as they are needed,
+// so a thread that records a few events holds one chunk, not the whole maximum.
+// The count is published with a release store, after the event (and its chunk), so
+// the exporting thread sees complete events even while the owner keeps appending.
+class thread_buffer {
+public:
+  explicit thread_buffer (std::uint32_t tid) : m_tid(tid) { }
+
+  void push (const event& ev) noexcept {
+    std::size_t n = m_count.load(std::memory_order_relaxed);
+    if (n == max_events_per_thread || !have_chunk(n / events_per_chunk)) {
+      // full, or out of memory; later events are counted but not kept
+      m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+      return;
+    }
+    m_chunks[n / events_per_chunk][n % events_per_chunk] = ev;
+    m_count.store(n + 1u, std::memory_order_release);
+  }
+
+  std::size_t size () const noexcept { return m_count.load(std::memory_order_acquire); }
+  const event& operator[] (std::size_t i) const noexcept {
+    return m_chunks[i / events_per_chunk][i % events_per_chunk];
+  }
+  std::size_t dropped () const noexcept { return m_dropped.load(std::memory_order_relaxed); }
+  std::uint32_t tid () const noexcept { return m_tid; }
+
+private:
+  bool have_chunk (std::size_t c) noexcept {
+    if (m_chunks[c] == nullptr) {
+      m_chunks[c].reset(new (std::nothrow) event[events_per_chunk]);
+    }
+    return m_chunks[c] != nullptr;
+  }
+
+  std::array<std::unique_ptr<event[]>, max_chunks_per_thread> m_chunks;
+  std::atomic<std::size_t> m_count {0u};
+  std::atomic<std::size_t> m_dropped {0u};
+  std::uint32_t m_tid;
+};
+
+// a copy of one thread's events, taken at export or when the thread exits
+struct thread_events {
+  std::uint32_t tid;
+  std::vector<event> events;
+  std::size_t dropped;
+};
+
+inline thread_events copy_events (const thread_buffer& buf) {
+  thread_events te { buf.tid(), { }, buf.dropped() };
+  std::size_t n = buf.size();
+  te.events.reserve(n);
+  for (std::size_t i {0u}; i < n; ++i) {
+    te.events.push_back(buf[i]);
+  }
+  return te;
+}
+
+// Holds the buffers of running threads. When a thread exits its events are
+// copied out, to exactly the size needed, and its buffer is released, so
+// short lived worker threads do not each keep their chunks until the process ends.
+class registry {
+public:
+  static registry& instance () {
+    static registry reg;
+    return reg;
+  }
+
+  std::shared_ptr<thread_buffer> add_thread () {
+    std::lock_guard<std::mutex> lk (m_mut);
+    m_live.push_back(std::make_shared<thread_buffer>(++m_last_tid));
+    return m_live.back();
+  }
+
+  void thread_exit (const thread_buffer& buf) {
+    auto te = copy_events(buf); // only the exiting thread writes to buf, so no lock needed
+    std::lock_guard<std::mutex> lk (m_mut);
+    std::erase_if(m_live, [&buf] (const auto& p) { return p.get() == &buf; });
+    if (!te.events.empty() || te.dropped != 0u) {
+      m_finished.push_back(std::move(te));
+    }
+  }
+
+  // every thread's events so far, running threads included
+  std::vector<thread_events> snapshot () const {
+    std::vector<std::shared_ptr<thread_buffer>> live;
+    std::vector<thread_events> all;
+    {
+      std::lock_guard<std::mutex> lk (m_mut);
+      live = m_live; // copies of the shared_ptrs keep the buffers alive if their threads exit
+      all = m_finished;
+    }
+    for (const auto& buf : live) {
+      all.push_back(copy_events(*buf));
+    }
+    return all;
+  }
+
+  // nanoseconds per tick, measured against steady_clock since the registry was created
+  double ns_per_tick () const noexcept {
+    auto t = ticks();
+    auto s = std::chrono::steady_clock::now();
+    return (t > m_start_ticks && s > m_start_time) ?
+           static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(s - m_start_time).count()) /
+             static_cast<double>(t - m_start_ticks) : 1.0;
+  }
+
+  std::uint64_t start_ticks () const noexcept { return m_start_ticks; }
+
+private:
+  registry () = default;
+
+  mutable std::mutex m_mut;
+  std::vector<std::shared_ptr<thread_buffer>> m_live;
+  std::vector<thread_events> m_finished;
+  std::uint32_t m_last_tid {0u};
+  std::chrono::steady_clock::time_point m_start_time { std::chrono::steady_clock::now() };
+  std::uint64_t m_start_ticks { ticks() };
+};
+
+namespace detail {
+
+// hands the thread's events to the registry when the thread exits
+class thread_handle {
+public:
+  thread_handle () : m_buf(registry::instance().add_thread()) { }
+  ~thread_handle () { registry::instance().thread_exit(*m_buf); }
+  thread_handle (const thread_handle&) = delete;
+  thread_handle& operator= (const thread_handle&) = delete;
+  thread_buffer& buffer () const noexcept { return *m_buf; }
+private:
+  std::shared_ptr<thread_buffer> m_buf;
+};
+
+}
+
+inline thread_buffer& this_thread_buffer () {
+  thread_local detail::thread_handle handle;
+  return handle.buffer();
+}
+
+inline void record (const char* name, std::uint64_t start, std::uint64_t end) {
+  this_thread_buffer().push(event{ name, start, end });
+}
+
+// records the time from construction to destruction
+class scope {
+public:
+  explicit scope (const char* name) : m_buf(this_thread_buffer()), m_name(name), m_start(ticks()) { }
+  ~scope () { m_buf.push(event{ m_name, m_start, ticks() }); }
+  scope (const scope&) = delete;
+  scope& operator= (const scope&) = delete;
+private:
+  thread_buffer& m_buf; // looked up before the start time is taken, not in the timed block
+  const char* m_name;
+  std::uint64_t m_start;
+};
+
+namespace detail {
+
+inline void write_json_string (std::ostream& os, const char* str) {
+  static constexpr char hex[] = "0123456789abcdef";
+  os << '"';
+  for (; *str != '\0'; ++str) {
+    auto ch = static_cast<unsigned char>(*str);
+    if (ch == '"' || ch == '\\') {
+      os << '\\' << *str;
+    }
+    else if (ch < 0x20u) {
+      os << "\\u00" << hex[ch >> 4] << hex[ch & 0xfu];
+    }
+    else {
+      os << *str;
+    }
+  }
+  os << '"';
+}
+
+}
+
+// all events recorded so far as "complete" (ph "X") events, times in microseconds
+// from when tracing started; returns the number of events written
+inline std::size_t write_chrome_trace (std::ostream& os) {
+  auto& reg = registry::instance();
+  double us_per_tick = reg.ns_per_tick() / 1000.0;
+  auto to_us = [&reg, us_per_tick] (std::uint64_t t) {
+    return (t > reg.start_ticks()) ? static_cast<double>(t - reg.start_ticks()) * us_per_tick : 0.0;
+  };
+  std::size_t cnt {0u};
+  std::size_t dropped {0u};
+  auto prev_flags = os.flags();
+  auto prev_prec = os.precision();
+  os << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+  for (const auto& te : reg.snapshot()) {
+    for (const event& ev : te.events) {
+      os << (cnt++ == 0u ? "\n" : ",\n") << "{\"name\":";
+      detail::write_json_string(os, ev.name);
+      os << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << te.tid << ",\"ts\":" << to_us(ev.start)
+         << ",\"dur\":" << (to_us(ev.end) - to_us(ev.start)) << '}';
+    }
+    dropped += te.dropped;
+  }
+  os << "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_events\":" << dropped << "}}\n";
+  os.flags(prev_flags);
+  os.precision(prev_prec);
+  return cnt;
+}
+
+inline std::size_t write_chrome_trace (const std::string& path) {
+  std::ofstream ofs (path);
+  return write_chrome_trace(ofs);
+}
+
+} // end namespace scoped_trace
+
+#define SCOPED_TRACE_CONCAT_IMPL(a, b) a##b
+#define SCOPED_TRACE_CONCAT(a, b) SCOPED_TRACE_CONCAT_IMPL(a, b)
+
+#if defined(SCOPED_TRACE_ENABLED)
+#define TRACE_SCOPE(name) ::scoped_trace::scope SCOPED_TRACE_CONCAT(scoped_trace_, __LINE__) { name }
+#else
+#define TRACE_SCOPE(name) static_cast<void>(0)
+#endif
+
+#endif
@@ -0,0 +1,74 @@
+/** @file
+ *
+ * @brief Catch2 event listener for @c scoped_trace, included once by each example
+ * test program.
+ *
+ * With tracing compiled in (@c SCOPED_TRACE_ENABLED), each test case is recorded
+ * as a trace scope, and at the end of the test run the trace is written to the
+ * file named by the @c SCOPED_TRACE_FILE environment variable, if it is set. For
+ * example:
+ *
+ * @code
+ * SCOPED_TRACE_FILE=trace.json intro_generic_programming/intro_generic_programming_test "[overload_tags]"
+ * @endcode
+ *
+ * The file can then be loaded into chrome://tracing or https://ui.perfetto.dev.
+ * Without @c SCOPED_TRACE_ENABLED this header does nothing.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2025 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef SCOPED_TRACE_CATCH2_HPP_INCLUDED
+#define SCOPED_TRACE_CATCH2_HPP_INCLUDED
+
+#include "scoped_trace.hpp"
+
+#if defined(SCOPED_TRACE_ENABLED)
+
+#include <cstdint>
+#include <cstdlib> // std::getenv
+#include <iostream>
+
+#include "catch2/reporters/catch_reporter_event_listener.hpp"
+#include "catch2/reporters/catch_reporter_registrars.hpp"
+
+// at global scope, CATCH_REGISTER_LISTENER takes an unqualified name
+class scoped_trace_listener : public Catch::EventListenerBase {
+public:
+  using Catch::EventListenerBase::EventListenerBase;
+
+  // the test case info is owned by the Catch2 registry, so the name outlives the export
+  // the buffer is looked up before the start time is taken, as in scoped_trace::scope;
+  // the first lookup creates the registry, whose creation time is time zero
+  void testCaseStarting (const Catch::TestCaseInfo& info) override {
+    m_name = info.name.c_str();
+    m_buf = &scoped_trace::this_thread_buffer();
+    m_start = scoped_trace::ticks();
+  }
+  void testCaseEnded (const Catch::TestCaseStats&) override {
+    m_buf->push(scoped_trace::event{ m_name, m_start, scoped_trace::ticks() });
+  }
+  void testRunEnded (const Catch::TestRunStats&) override {
+    if (const char* path = std::getenv("SCOPED_TRACE_FILE"); path != nullptr && *path != '\0') {
+      auto cnt = scoped_trace::write_chrome_trace(std::string(path));
+      std::cerr << "scoped_trace: " << cnt << " events written to " << path << '\n';
+    }
+  }
+
+private:
+  scoped_trace::thread_buffer* m_buf { nullptr };
+  const char* m_name { "" };
+  std::uint64_t m_start {0u};
+};
+
+CATCH_REGISTER_LISTENER(scoped_trace_listener)
+
+#endif
+
+#endif
@@ -23,21 +23,57 @@
 
 
 #include <algorithm>
+#include <iterator>
+#include <cstddef> // std::ptrdiff_t, std::size_t
+#include <memory> // std::allocator, std::destroy, std::uninitialized_default_construct_n
+#include <new> // std::align_val_t, std::launder
+#include <span>
+#include <stdexcept>
+#include <utility> // std::move, std::pair
 #include <vector>
 #include <list>
 #include <array>
-#include <functional> // std::ref
+#include <functional> // std::ref, std::invoke, std::identity
 #include <complex>
 #include <string>
+#include <string_view>
 #include <type_traits>
+#include <concepts>
+#include <bit> // std::bit_cast
+#include <cstdint>
+#include <cassert>
+#include <cmath> // std::isnan
+#include <limits>
+#include <cstring> // std::memcpy
+#include <charconv> // std::from_chars, std::to_chars
+#include <system_error> // std::errc
 #include <tuple>
 #include <optional>
+#include <random>
+#include <numeric> // std::iota
+#include <ranges>
+#include <thread>
+#include <atomic>
+#include <future> // std::async
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <exception> // std::exception_ptr
+#include <coroutine>
+#if defined(BENCH_STD_EXECUTION_PAR) // set by the CMake file when a parallel backend is available
+#include <execution>
+#endif
 
 #include "decimal.h" // library providing decimal point functionality
 
 #include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
 #include "catch2/matchers/catch_matchers.hpp"
 #include "catch2/matchers/catch_matchers_range_equals.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+
+#include "scoped_trace_catch2.hpp" // TRACE_SCOPE, and the trace file written at the end of a test run
+#include "batch_kernels.hpp" // batch::add_div_by_3, batch::add_sub_div, with run time ISA dispatch
 
 ////////////////////
 // Slide 7
@@ -46,27 +82,763 @@
 struct bidirectional_iterator_tag { }; 
 struct random_access_iterator_tag : public bidirectional_iterator_tag { };
 
+// A real random access sort - a parallel merge sort. The range is split in half
+// recursively down to the cutoff, where std::sort takes over, and the sorted halves
+// are merged in parallel (each merge is split by a binary search so both sides of
+// the split can run at the same time). The pieces are run by a work stealing pool,
+// so the threads are started once, and a thread that runs out of work takes some
+// from a busy one. Both tuning knobs can be set by the application; the thread
+// count is read when the pool is first used.
+
+// A work stealing pool for fork-join parallelism. Each participating thread has
+// its own deque of tasks: it pushes and pops at the back (the most recently forked,
+// smallest piece of work, whose data is still in cache), and idle threads steal
+// from the front (the oldest, largest pieces). fork_join(f1, f2) makes f1 available
+// to other threads, runs f2 itself, and then, until f1 is done, runs other tasks
+// (most often f1 itself, if nobody stole it) instead of blocking. The thread that
+// calls fork_join from outside the pool takes part too, so a pool of size n starts
+// n - 1 worker threads, and a pool of size 1 runs everything on the caller.
+class ws_pool {
+public:
+  explicit ws_pool (unsigned threads) : m_queues(std::max(1u, threads)) {
+    for (unsigned i {1u}; i < m_queues.size(); ++i) {
+      m_workers.emplace_back([this, i] { worker_loop(i); } );
+    }
+  }
+  ~ws_pool () {
+    {
+      std::lock_guard<std::mutex> lk (m_sleep_mut);
+      m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& w : m_workers) {
+      w.join();
+    }
+  }
+  ws_pool (const ws_pool&) = delete;
+  ws_pool& operator= (const ws_pool&) = delete;
+
+  unsigned size () const noexcept { return static_cast<unsigned>(m_queues.size()); }
+
+  // runs f1 and f2, possibly at the same time; an exception from either is rethrown
+  // (f2's first) after both have finished
+  template <typename F1, typename F2>
+  void fork_join (F1 f1, F2 f2) {
+    task t { [] (void* f) { (*static_cast<F1*>(f))(); }, &f1 };
+    unsigned self { queue_index() };
+    push(self, &t);
+    std::exception_ptr ex;
+    try {
+      f2();
+    }
+    catch (...) {
+      ex = std::current_exception();
+    }
+    while (!t.done.load(std::memory_order_acquire)) {
+      if (!run_one(self)) {
+        std::this_thread::yield(); // f1 was stolen and is still running
+      }
+    }
+    if (ex) { std::rethrow_exception(ex); }
+    if (t.ex) { std::rethrow_exception(t.ex); }
+  }
+
+private:
+  struct task {
+    void (*run)(void*);
+    void* func;
+    std::atomic<bool> done { false };
+    std::exception_ptr ex { };
+  };
+  struct queue {
+    std::mutex mut;
+    std::deque<task*> tasks;
+  };
+
+  // queue 0 is shared by the threads calling in from outside the pool
+  unsigned queue_index () const noexcept { return t_pool == this ? t_index : 0u; }
+
+  void push (unsigned q, task* t) {
+    {
+      std::lock_guard<std::mutex> lk (m_queues[q].mut);
+      m_queues[q].tasks.push_back(t);
+    }
+    m_pending.fetch_add(1);
+    if (m_sleeping.load() > 0) {
+      std::lock_guard<std::mutex> lk (m_sleep_mut);
+      m_wake.notify_one();
+    }
+  }
+
+  task* take (unsigned q, bool back) {
+    std::lock_guard<std::mutex> lk (m_queues[q].mut);
+    auto& tasks = m_queues[q].tasks;
+    if (tasks.empty()) { return nullptr; }
+    task* t { back ? tasks.back() : tasks.front() };
+    if (back) { tasks.pop_back(); } else { tasks.pop_front(); }
+    m_pending.fetch_sub(1);
+    return t;
+  }
+
+  // the thread's own newest task, or else the oldest task of another thread
+  bool run_one (unsigned self) {
+    task* t { take(self, true) };
+    for (unsigned i {1u}; t == nullptr && i < size(); ++i) {
+      t = take((self + i) % size(), false);
+    }
+    if (t == nullptr) { return false; }
+    try {
+      t->run(t->func);
+    }
+    catch (...) {
+      t->ex = std::current_exception();
+    }
+    t->done.store(true, std::memory_order_release);
+    return true;
+  }
+
+  void worker_loop (unsigned idx) {
+    t_pool = this;
+    t_index = idx;
+    while (true) {
+      if (run_one(idx)) { continue; }
+      std::unique_lock<std::mutex> lk (m_sleep_mut);
+      ++m_sleeping;
+      m_wake.wait(lk, [this] { return m_stop || m_pending.load() > 0; } );
+      --m_sleeping;
+      if (m_stop) { return; } // fork_join does not return before its tasks are done
+    }
+  }
+
+  inline static thread_local const ws_pool* t_pool { nullptr };
+  inline static thread_local unsigned t_index { 0u };
+
+  std::vector<queue> m_queues;
+  std::vector<std::thread> m_workers;
+  std::atomic<int> m_pending {0};
+  std::atomic<int> m_sleeping {0};
+  std::mutex m_sleep_mut;
+  std::condition_variable m_wake;
+  bool m_stop { false };
+};
+
+// uninitialized storage for n Ts, or none if the allocation fails
+template <typename T>
+class merge_scratch {
+public:
+  explicit merge_scratch (std::size_t n) noexcept :
+    m_buf(static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{alignof(T)}, std::nothrow))) { }
+  ~merge_scratch () { ::operator delete(m_buf, std::align_val_t{alignof(T)}); }
+  merge_scratch (const merge_scratch&) = delete;
+  merge_scratch& operator= (const merge_scratch&) = delete;
+  T* get () const noexcept { return m_buf; }
+private:
+  T* m_buf;
+};
+
+inline std::ptrdiff_t par_sort_cutoff { 1 << 16 }; // below this size, plain std::sort
+inline unsigned par_sort_threads { std::max(1u, std::thread::hardware_concurrency()) };
+
+// the pool par_sort uses unless it is given one, started on first use with
+// par_sort_threads threads
+inline ws_pool& sort_pool () {
+  static ws_pool pool { par_sort_threads };
+  return pool;
+}
+
+template <typename InIter, typename OutIter, typename Compare>
+void par_merge (InIter b1, InIter e1, InIter b2, InIter e2, OutIter out, Compare comp,
+                ws_pool& pool, std::ptrdiff_t cutoff) {
+  auto len1 = e1 - b1;
+  auto len2 = e2 - b2;
+  if (pool.size() < 2u || (len1 + len2) <= cutoff) {
+    std::merge(std::make_move_iterator(b1), std::make_move_iterator(e1),
+               std::make_move_iterator(b2), std::make_move_iterator(e2), out, comp);
+    return;
+  }
+  InIter m1 = b1;
+  InIter m2 = b2;
+  if (len1 >= len2) {
+    m1 = b1 + len1 / 2;
+    m2 = std::lower_bound(b2, e2, *m1, comp);
+  }
+  else {
+    m2 = b2 + len2 / 2;
+    m1 = std::upper_bound(b1, e1, *m2, comp);
+  }
+  OutIter out_mid = out + (m1 - b1) + (m2 - b2);
+  pool.fork_join([=, &pool] { par_merge(b1, m1, b2, m2, out, comp, pool, cutoff); },
+                 [=, &pool] { par_merge(m1, e1, m2, e2, out_mid, comp, pool, cutoff); } );
+}
+
+// Sorts [first, last). The result ends up in [first, last), or, if to_other, in the
+// range of the same length starting at other. Both ranges hold live objects, so
+// every step is a move assignment. The halves are sorted into whichever range the
+// merge then reads from, so the merges go back and forth between the two ranges
+// instead of each one being moved back.
+template <typename Iter, typename OtherIter, typename Compare>
+void par_merge_sort (Iter first, Iter last, OtherIter other, bool to_other, Compare comp,
+                     ws_pool& pool, std::ptrdiff_t cutoff) {
+  auto len = last - first;
+  if (len <= cutoff) {
+    std::sort(first, last, comp);
+    if (to_other) {
+      std::move(first, last, other);
+    }
+    return;
+  }
+  auto half = len / 2;
+  pool.fork_join([=, &pool] { par_merge_sort(first, first + half, other, !to_other, comp, pool, cutoff); },
+                 [=, &pool] { par_merge_sort(first + half, last, other + half, !to_other, comp, pool, cutoff); } );
+  if (to_other) {
+    par_merge(first, first + half, first + half, last, other, comp, pool, cutoff);
+  }
+  else {
+    par_merge(other, other + half, other + half, other + len, first, comp, pool, cutoff);
+  }
+}
+
+template <typename RAIter, typename Compare>
+void par_sort (RAIter begin, RAIter end, Compare comp,
+               ws_pool& pool = sort_pool(), std::ptrdiff_t cutoff = par_sort_cutoff) {
+  using value_type = std::iter_value_t<RAIter>;
+  auto len = end - begin;
+  if (pool.size() < 2u || len <= cutoff) {
+    std::sort(begin, end, comp);
+    return;
+  }
+  merge_scratch<value_type> scratch (static_cast<std::size_t>(len));
+  if (scratch.get() == nullptr) { // no memory for the buffer
+    std::sort(begin, end, comp);
+    return;
+  }
+  // the elements are moved into the (uninitialized) buffer, which leaves live moved
+  // from objects in the range, and the sorted result is merged back into the range
+  value_type* buf_end = std::uninitialized_move(begin, end, scratch.get());
+  struct destroy_guard {
+    value_type* first;
+    value_type* last;
+    ~destroy_guard () { std::destroy(first, last); }
+  } guard { scratch.get(), buf_end };
+  par_merge_sort(scratch.get(), buf_end, begin, true, comp, pool, cutoff);
+}
+
+template <typename RAIter, typename Compare = std::less<>>
+void sort_alg (RAIter begin, RAIter end, random_access_iterator_tag, Compare comp = Compare{}) {
+  TRACE_SCOPE("sort_alg, parallel merge sort");
+  par_sort(begin, end, comp);
+}
+
+// Sorting by a projected key, e.g. &person::name - the key of each element is
+// extracted once into a contiguous array of key and index pairs, that array is
+// (stable) sorted, and then the elements are put into place by following the cycles
+// of the resulting permutation, moving each element exactly once. Compares never
+// copy elements (a compare lambda taking its parameters by value copies two
+// elements for every compare). Trivially copyable keys, or keys the projection
+// returns by value, are stored in the array; other keys are pointed to.
+
+template <typename Key, typename Iter>
+using projected_t = std::invoke_result_t<Key&, std::iter_reference_t<Iter>>;
+
+template <typename Key, typename Iter>
+concept key_projection = std::invocable<Key&, std::iter_reference_t<Iter>> &&
+                         std::totally_ordered<std::remove_cvref_t<projected_t<Key, Iter>>>;
+
+template <typename Key, typename Iter>
+using cached_key_t = std::conditional_t<
+        std::is_lvalue_reference_v<projected_t<Key, Iter>> &&
+        !std::is_trivially_copyable_v<std::remove_cvref_t<projected_t<Key, Iter>>>,
+      const std::remove_cvref_t<projected_t<Key, Iter>>*,
+      std::remove_cvref_t<projected_t<Key, Iter>>>;
+
+template <typename T>
+constexpr const auto& deref_key (const T& k) noexcept {
+  if constexpr (std::is_pointer_v<T>) { return *k; }
+  else { return k; }
+}
+
 template <typename RAIter>
-void sort_alg (RAIter begin, RAIter end, random_access_iterator_tag) {
-  std::sort(begin, end);
-  REQUIRE (std::is_sorted(begin, end));
+void apply_permutation (RAIter begin, std::vector<std::size_t>& src_idx) {
+  // position i receives the element currently at src_idx[i]; entries are set to
+  // their own index as they are done
+  for (std::size_t i {0u}; i < src_idx.size(); ++i) {
+    if (src_idx[i] == i) { continue; }
+    auto tmp = std::move(begin[static_cast<std::ptrdiff_t>(i)]);
+    std::size_t j { i };
+    while (src_idx[j] != i) {
+      auto k = src_idx[j];
+      begin[static_cast<std::ptrdiff_t>(j)] = std::move(begin[static_cast<std::ptrdiff_t>(k)]);
+      src_idx[j] = j;
+      j = k;
+    }
+    begin[static_cast<std::ptrdiff_t>(j)] = std::move(tmp);
+    src_idx[j] = j;
+  }
+}
+
+// String keys get their own mode - the first 8 bytes of each string are packed
+// big endian into a std::uint64_t, so that most compares are a single integer
+// compare on data that sits in the key array, instead of following a pointer into
+// the heap. Only when two prefixes are equal are the strings themselves compared
+// (std::string compares bytes as unsigned char, which is what the prefix does too).
+// Ties are broken by index, which makes the result stable.
+
+template <typename Key, typename Iter>
+concept string_key_projection = key_projection<Key, Iter> &&
+         std::convertible_to<projected_t<Key, Iter>, std::string_view> &&
+         (std::is_lvalue_reference_v<projected_t<Key, Iter>> || // view must not dangle
+          std::same_as<std::remove_cvref_t<projected_t<Key, Iter>>, std::string_view>);
+
+constexpr std::uint64_t string_prefix (std::string_view str) noexcept {
+  std::uint64_t prefix {0u};
+  for (std::size_t i {0u}; i < 8u; ++i) {
+    prefix = (prefix << 8u) | (i < str.size() ? static_cast<unsigned char>(str[i]) : 0u);
+  }
+  return prefix;
+}
+
+template <typename RAIter, typename Key>
+  requires string_key_projection<Key, RAIter>
+void string_prefix_sort (RAIter begin, RAIter end, Key key) {
+  struct prefix_key {
+    std::uint64_t prefix;
+    std::string_view str;
+    std::size_t idx;
+  };
+  auto n = static_cast<std::size_t>(end - begin);
+  std::vector<prefix_key> keyed;
+  keyed.reserve(n);
+  for (std::size_t i {0u}; i < n; ++i) {
+    std::string_view str { std::invoke(key, begin[static_cast<std::ptrdiff_t>(i)]) };
+    keyed.push_back(prefix_key { string_prefix(str), str, i });
+  }
+  std::sort(keyed.begin(), keyed.end(), [] (const prefix_key& a, const prefix_key& b) {
+      if (a.prefix != b.prefix) { return a.prefix < b.prefix; }
+      auto cmp = (a.str.size() >= 8u && b.str.size() >= 8u) ?
+                 a.str.substr(8u).compare(b.str.substr(8u)) : a.str.compare(b.str);
+      return cmp != 0 ? cmp < 0 : a.idx < b.idx; } );
+  std::vector<std::size_t> src_idx(n);
+  std::transform(keyed.begin(), keyed.end(), src_idx.begin(), [] (const prefix_key& k) { return k.idx; } );
+  apply_permutation(begin, src_idx);
+}
+
+template <typename RAIter, typename Key, typename Compare = std::less<>>
+  requires key_projection<Key, RAIter>
+void key_index_sort (RAIter begin, RAIter end, Key key, Compare comp = Compare{}) {
+  if constexpr (string_key_projection<Key, RAIter> && std::same_as<Compare, std::less<>>) {
+    string_prefix_sort(begin, end, key);
+  }
+  else {
+    using cached_key = cached_key_t<Key, RAIter>;
+    auto n = static_cast<std::size_t>(end - begin);
+    std::vector<std::pair<cached_key, std::size_t>> keyed;
+    keyed.reserve(n);
+    for (std::size_t i {0u}; i < n; ++i) {
+      if constexpr (std::is_pointer_v<cached_key>) {
+        keyed.emplace_back(&std::invoke(key, begin[static_cast<std::ptrdiff_t>(i)]), i);
+      }
+      else {
+        keyed.emplace_back(std::invoke(key, begin[static_cast<std::ptrdiff_t>(i)]), i);
+      }
+    }
+    std::stable_sort(keyed.begin(), keyed.end(), [&comp] (const auto& a, const auto& b) {
+        return comp(deref_key(a.first), deref_key(b.first)); } );
+    std::vector<std::size_t> src_idx(n);
+    std::transform(keyed.begin(), keyed.end(), src_idx.begin(), [] (const auto& k) { return k.second; } );
+    apply_permutation(begin, src_idx);
+  }
+}
+
+// no default for the key, since a plain range of strings (for example) is better
+// off with the comparison sort
+template <typename RAIter, typename Key>
+  requires key_projection<Key, RAIter>
+void sort_alg (RAIter begin, RAIter end, random_access_iterator_tag, Key key) {
+  TRACE_SCOPE("sort_alg, key index sort");
+  key_index_sort(begin, end, key);
+}
+
+// A third member of the sort_alg family - an LSD radix sort, chosen automatically
+// (through the radix_key_projection concept) when the element type, or the key
+// projected out of each element, is an integral or floating point type. The
+// overload is otherwise identical to the ones above, so being more constrained is
+// what makes it win (radix_key_projection subsumes key_projection). A binary compare
+// function is not a unary projection, so passing one still selects the comparison sort.
+//
+// Keys are mapped to unsigned integers that sort the same way (sign bit flipped,
+// negative floats inverted), and one pass is made per key byte. All of the byte
+// histograms are built in a single read of the data, and passes where every key
+// has the same byte value are skipped - unsigned 32 bit ages below 256 need only
+// one pass. Elements are moved between the range and a scratch buffer which the
+// caller can keep and reuse across calls.
+
+template <typename T>
+concept radix_key = (std::integral<T> && !std::same_as<T, bool>) ||
+                    (std::floating_point<T> && (sizeof(T) == 4u || sizeof(T) == 8u));
+
+template <typename Key, typename Iter>
+concept radix_key_projection = key_projection<Key, Iter> &&
+                               radix_key<std::remove_cvref_t<projected_t<Key, Iter>>>;
+
+template <radix_key T>
+constexpr auto radix_bits (T k) noexcept {
+  if constexpr (std::floating_point<T>) {
+    using U = std::conditional_t<sizeof(T) == 4u, std::uint32_t, std::uint64_t>;
+    constexpr U sign_bit = U{1} << (sizeof(U) * 8u - 1u);
+    auto u = std::bit_cast<U>(k);
+    return (u & sign_bit) ? static_cast<U>(~u) : static_cast<U>(u | sign_bit);
+  }
+  else {
+    using U = std::make_unsigned_t<T>;
+    auto u = static_cast<U>(k);
+    if constexpr (std::is_signed_v<T>) {
+      u = static_cast<U>(u ^ (U{1} << (sizeof(U) * 8u - 1u)));
+    }
+    return u;
+  }
+}
+
+template <typename RAIter, typename Key>
+  requires radix_key_projection<Key, RAIter>
+void radix_sort (RAIter begin, RAIter end, Key key, std::vector<std::iter_value_t<RAIter>>& scratch) {
+  auto bits_of = [&key] (const auto& elem) { return radix_bits(std::invoke(key, elem)); };
+  using bits_type = decltype(bits_of(*begin));
+  constexpr std::size_t num_bytes { sizeof(bits_type) };
+
+  auto n = static_cast<std::size_t>(end - begin);
+  if (n < 2u) { return; }
+  std::array<std::array<std::size_t, 256u>, num_bytes> counts { };
+  for (auto it = begin; it != end; ++it) {
+    auto bits = bits_of(*it);
+    for (std::size_t b {0u}; b < num_bytes; ++b) {
+      ++counts[b][(bits >> (8u * b)) & 0xFFu];
+    }
+  }
+  auto first_bits = bits_of(*begin);
+  scratch.resize(n);
+  bool in_scratch { false };
+  for (std::size_t b {0u}; b < num_bytes; ++b) {
+    if (counts[b][(first_bits >> (8u * b)) & 0xFFu] == n) { continue; } // pass would not move anything
+    std::array<std::size_t, 256u> pos;
+    std::size_t sum {0u};
+    for (std::size_t i {0u}; i < 256u; ++i) {
+      pos[i] = sum;
+      sum += counts[b][i];
+    }
+    auto scatter = [&] (auto src_begin, auto src_end, auto dst) {
+      for (auto it = src_begin; it != src_end; ++it) {
+        auto idx = pos[(bits_of(*it) >> (8u * b)) & 0xFFu]++;
+        dst[static_cast<std::ptrdiff_t>(idx)] = std::move(*it);
+      }
+    };
+    if (in_scratch) {
+      scatter(scratch.begin(), scratch.end(), begin);
+    }
+    else {
+      scatter(begin, end, scratch.begin());
+    }
+    in_scratch = !in_scratch;
+  }
+  if (in_scratch) {
+    std::move(scratch.begin(), scratch.end(), begin);
+  }
+}
+
+template <typename RAIter, typename Key = std::identity>
+  requires radix_key_projection<Key, RAIter> && std::default_initializable<std::iter_value_t<RAIter>>
+void sort_alg (RAIter begin, RAIter end, random_access_iterator_tag, Key key = Key{}) {
+  TRACE_SCOPE("sort_alg, radix sort");
+  thread_local std::vector<std::iter_value_t<RAIter>> scratch; // capacity is kept between calls
+  radix_sort(begin, end, key, scratch);
+}
+
+// A real bidirectional sort - a stable merge sort that sorts the range itself,
+// moving elements through the iterators, so sorting a std::list does not create
+// (or destroy) any nodes. Short runs are insertion sorted. The merge step moves the
+// left run into a scratch buffer and merges from there back into the range; the one
+// buffer (room for half the range) is allocated up front, uninitialized, and reused
+// by every merge. If that allocation fails, the merge falls back to the classic
+// "merge without buffer" (rotate the out of order middle pieces, then recurse),
+// which needs no memory but is O(n log^2 n) instead of O(n log n).
+
+constexpr std::ptrdiff_t bidi_insertion_cutoff { 16 };
+
+template <typename Iter, typename Compare>
+void insertion_sort_bidi (Iter begin, Iter end, Compare comp) {
+  if (begin == end) { return; }
+  for (Iter i = std::next(begin); i != end; ++i) {
+    auto val = std::move(*i);
+    Iter j = i;
+    while (j != begin) {
+      Iter k = std::prev(j);
+      if (!comp(val, *k)) { break; } // !(val < *k) keeps equal elements in order
+      *j = std::move(*k);
+      j = k;
+    }
+    *j = std::move(val);
+  }
+}
+
+template <typename Iter, typename Compare>
+void merge_in_place (Iter begin, Iter mid, Iter end,
+                     std::ptrdiff_t len1, std::ptrdiff_t len2, Compare comp) {
+  if (len1 == 0 || len2 == 0) { return; }
+  if (len1 + len2 == 2) {
+    if (comp(*mid, *begin)) { std::iter_swap(begin, mid); }
+    return;
+  }
+  Iter cut1 = begin;
+  Iter cut2 = mid;
+  std::ptrdiff_t dist1 {0};
+  std::ptrdiff_t dist2 {0};
+  if (len1 > len2) {
+    dist1 = len1 / 2;
+    std::advance(cut1, dist1);
+    cut2 = std::lower_bound(mid, end, *cut1, comp);
+    dist2 = std::distance(mid, cut2);
+  }
+  else {
+    dist2 = len2 / 2;
+    std::advance(cut2, dist2);
+    cut1 = std::upper_bound(begin, mid, *cut2, comp);
+    dist1 = std::distance(begin, cut1);
+  }
+  Iter new_mid = std::rotate(cut1, mid, cut2);
+  merge_in_place(begin, cut1, new_mid, dist1, dist2, comp);
+  merge_in_place(new_mid, cut2, end, len1 - dist1, len2 - dist2, comp);
+}
+
+// buf has room for at least the left run, [begin, mid)
+template <typename Iter, typename T, typename Compare>
+void merge_buffered (Iter begin, Iter mid, Iter end, T* buf, Compare comp) {
+  T* buf_end = std::uninitialized_move(begin, mid, buf);
+  struct destroy_guard {
+    T* first;
+    T* last;
+    ~destroy_guard () { std::destroy(first, last); }
+  } guard { buf, buf_end };
+  T* left = buf;
+  Iter right = mid;
+  Iter out = begin;
+  while (left != buf_end && right != end) {
+    if (comp(*right, *left)) { // equal elements are taken from the left run, keeping it stable
+      *out = std::move(*right);
+      ++right;
+    }
+    else {
+      *out = std::move(*left);
+      ++left;
+    }
+    ++out;
+  }
+  std::move(left, buf_end, out); // whatever is left of the right run is already in place
+}
+
+template <typename Iter, typename Compare>
+void merge_sort_bidi (Iter begin, Iter end, std::ptrdiff_t len, std::iter_value_t<Iter>* buf, Compare comp) {
+  if (len <= bidi_insertion_cutoff) {
+    insertion_sort_bidi(begin, end, comp);
+    return;
+  }
+  auto half = len / 2;
+  Iter mid = std::next(begin, half);
+  merge_sort_bidi(begin, mid, half, buf, comp);
+  merge_sort_bidi(mid, end, len - half, buf, comp);
+  if (!comp(*mid, *std::prev(mid))) { return; } // halves already in order
+  if (buf != nullptr) {
+    merge_buffered(begin, mid, end, buf, comp);
+  }
+  else {
+    merge_in_place(begin, mid, end, half, len - half, comp);
+  }
 }
 
-template <typename Iter>
-void sort_alg (Iter begin, Iter end, bidirectional_iterator_tag) {
-// a real bidirectional sort would be implemented here, this code
-// is only for unit test coverage; see presentation for more info
-  std::list lst(begin, end);
-  lst.sort();
-  REQUIRE (std::is_sorted(lst.begin(), lst.end()));
+template <typename Iter, typename Compare = std::less<>>
+void sort_alg (Iter begin, Iter end, bidirectional_iterator_tag, Compare comp = Compare{}) {
+  TRACE_SCOPE("sort_alg, bidirectional merge sort");
+  auto len = std::distance(begin, end);
+  if (len <= bidi_insertion_cutoff) {
+    insertion_sort_bidi(begin, end, comp);
+    return;
+  }
+  // a left run is never longer than half the range
+  merge_scratch<std::iter_value_t<Iter>> scratch (static_cast<std::size_t>(len / 2));
+  merge_sort_bidi(begin, end, len, scratch.get(), comp);
 }
 
+// allocator that counts allocations, used to show that the bidirectional sort does not
+// allocate list nodes
+inline std::size_t alloc_count { 0 };
+
+template <typename T>
+struct counting_alloc {
+  using value_type = T;
+  counting_alloc() = default;
+  template <typename U>
+  counting_alloc(const counting_alloc<U>&) noexcept { }
+  T* allocate(std::size_t n) { ++alloc_count; return std::allocator<T>{}.allocate(n); }
+  void deallocate(T* p, std::size_t n) noexcept { std::allocator<T>{}.deallocate(p, n); }
+  friend bool operator== (const counting_alloc&, const counting_alloc&) { return true; }
+};
 
 TEST_CASE ("Types as function overload tags", "[overload_tags]") {
   std::vector v { 50, 10, 1, 60, };
   sort_alg(v.begin(), v.end(), random_access_iterator_tag{});
+  REQUIRE_THAT(v, Catch::Matchers::RangeEquals(std::vector<int>{1, 10, 50, 60}));
   std::list ls { 50, 10, 1, 60, };
   sort_alg(ls.begin(), ls.end(), bidirectional_iterator_tag{});
+  REQUIRE_THAT(ls, Catch::Matchers::RangeEquals(std::vector<int>{1, 10, 50, 60}));
+}
+
+TEST_CASE ("Bidirectional sort is in place and stable", "[overload_tags][bidi_sort]") {
+
+  SECTION ("Empty and single element ranges") {
+    std::list<int> ls;
+    sort_alg(ls.begin(), ls.end(), bidirectional_iterator_tag{});
+    REQUIRE (ls.empty());
+    ls.push_back(42);
+    sort_alg(ls.begin(), ls.end(), bidirectional_iterator_tag{});
+    REQUIRE (ls.front() == 42);
+  }
+
+  SECTION ("Larger range, no list nodes allocated") {
+    std::list<int, counting_alloc<int>> ls;
+    for (int i {0}; i < 1000; ++i) {
+      ls.push_back((i * 7919) % 1009);
+    }
+    alloc_count = 0;
+    sort_alg(ls.begin(), ls.end(), bidirectional_iterator_tag{});
+    REQUIRE (std::is_sorted(ls.begin(), ls.end()));
+    REQUIRE (ls.size() == 1000u);
+    REQUIRE (alloc_count == 0u);
+  }
+
+  SECTION ("Equal keys keep their original order") {
+    using rec = std::pair<int, int>; // key, original position
+    std::list<rec> ls;
+    for (int i {0}; i < 500; ++i) {
+      ls.emplace_back(i % 7, i);
+    }
+    sort_alg(ls.begin(), ls.end(), bidirectional_iterator_tag{},
+             [] (const rec& a, const rec& b) { return a.first < b.first; } );
+    REQUIRE (std::is_sorted(ls.begin(), ls.end())); // sorted by key, then position
+  }
+
+  SECTION ("Without a scratch buffer, the in place merge") {
+    using rec = std::pair<int, int>;
+    std::list<rec> ls;
+    for (int i {0}; i < 500; ++i) {
+      ls.emplace_back((i * 7919) % 13, i);
+    }
+    merge_sort_bidi(ls.begin(), ls.end(), std::ssize(ls), static_cast<rec*>(nullptr),
+                    [] (const rec& a, const rec& b) { return a.first < b.first; } );
+    REQUIRE (std::is_sorted(ls.begin(), ls.end()));
+  }
+}
+
+TEST_CASE ("Parallel random access sort", "[overload_tags][par_sort]") {
+  std::vector<int> v(10'000);
+  for (std::size_t i {0}; i < v.size(); ++i) {
+    v[i] = static_cast<int>((i * 7919u) % 10'007u) - 5'000;
+  }
+  auto expected = v;
+  std::sort(expected.begin(), expected.end());
+
+  SECTION ("Small cutoff so that the threaded path is taken") {
+    for (unsigned threads : { 1u, 2u, 3u, 4u, 8u }) {
+      ws_pool pool { threads };
+      auto w = v;
+      par_sort(w.begin(), w.end(), std::less<>{}, pool, 100);
+      REQUIRE (w == expected);
+    }
+  }
+
+  SECTION ("Descending compare, strings") {
+    std::vector<std::string> strs;
+    for (int i : v) {
+      strs.push_back(std::to_string(i));
+    }
+    ws_pool pool { 4u };
+    par_sort(strs.begin(), strs.end(), std::greater<>{}, pool, 64);
+    REQUIRE (std::is_sorted(strs.begin(), strs.end(), std::greater<>{}));
+  }
+
+  SECTION ("Element type without a default constructor") {
+    struct no_default {
+      explicit no_default (int x) : val(x) { }
+      int val;
+    };
+    std::vector<no_default> nd;
+    for (int i : v) {
+      nd.emplace_back(i);
+    }
+    ws_pool pool { 3u };
+    par_sort(nd.begin(), nd.end(), [] (const no_default& a, const no_default& b) { return a.val < b.val; },
+             pool, 100);
+    REQUIRE (std::ranges::equal(nd, expected, { }, &no_default::val));
+  }
+
+  SECTION ("An exception from the compare reaches the caller") {
+    ws_pool pool { 4u };
+    auto w = v;
+    std::atomic<int> compares {0};
+    auto throwing_less = [&compares] (int a, int b) {
+      if (++compares == 50'000) { throw std::runtime_error("compare"); }
+      return a < b;
+    };
+    REQUIRE_THROWS_AS (par_sort(w.begin(), w.end(), throwing_less, pool, 100), std::runtime_error);
+  }
+
+  SECTION ("Through the tag dispatch entry point, with default tuning") {
+    sort_alg(v.begin(), v.end(), random_access_iterator_tag{}, std::less<>{});
+    REQUIRE (v == expected);
+  }
+}
+
+TEST_CASE ("Radix sort for integral and floating point keys", "[overload_tags][radix_sort]") {
+
+  SECTION ("Signed ints, selected by the concept") {
+    std::vector<int> v { 50, -10, 1, 60, -2'000'000'000, 0, 2'000'000'000, 1, };
+    sort_alg(v.begin(), v.end(), random_access_iterator_tag{});
+    REQUIRE_THAT(v, Catch::Matchers::RangeEquals(
+                 std::vector<int>{-2'000'000'000, -10, 0, 1, 1, 50, 60, 2'000'000'000}));
+  }
+
+  SECTION ("Doubles, including negative and zero values") {
+    std::vector<double> v { 3.5, -0.25, 0.0, -1.0e10, 1.0e-10, 42.0, -3.5 };
+    sort_alg(v.begin(), v.end(), random_access_iterator_tag{});
+    REQUIRE_THAT(v, Catch::Matchers::RangeEquals(
+                 std::vector<double>{-1.0e10, -3.5, -0.25, 0.0, 1.0e-10, 3.5, 42.0}));
+  }
+
+  SECTION ("Projected key, stable, with a reused scratch buffer") {
+    using rec = std::pair<unsigned char, int>; // key, original position
+    std::vector<rec> v;
+    for (int i {0}; i < 5'000; ++i) {
+      v.emplace_back(static_cast<unsigned char>((i * 31) % 7), i);
+    }
+    std::vector<rec> scratch;
+    radix_sort(v.begin(), v.end(), &rec::first, scratch);
+    REQUIRE (std::is_sorted(v.begin(), v.end())); // sorted by key, then position
+    auto cap = scratch.capacity();
+    radix_sort(v.begin(), v.end(), [] (const rec& r) { return -r.second; }, scratch);
+    REQUIRE (v.front().second == 4'999);
+    REQUIRE (v.back().second == 0);
+    REQUIRE (scratch.capacity() == cap);
+  }
+
+  SECTION ("Large random range against std::sort") {
+    std::vector<long long> v(100'000);
+    std::uint64_t x { 88172645463325252ull }; // xorshift
+    for (auto& e : v) {
+      x ^= x << 13u; x ^= x >> 7u; x ^= x << 17u;
+      e = static_cast<long long>(x);
+    }
+    auto expected = v;
+    std::sort(expected.begin(), expected.end());
+    sort_alg(v.begin(), v.end(), random_access_iterator_tag{});
+    REQUIRE (v == expected);
+  }
 }
 
 ////////////////////
@@ -202,6 +974,83 @@ TEST_CASE ("Function template", "[function_template]") {
 
 }
 
+////////////////////
+// Beyond the slides - batch versions of the slide 17 and 18 function templates
+//
+// The same formulas applied to whole spans of int, unsigned, float or double. The
+// loops are the batch kernels in examples/common/batch_kernels.hpp, compiled once
+// per x86 instruction set level (SSE4.2, AVX2, AVX-512) and chosen at run time for
+// the CPU the program runs on, so they vectorize with the widest registers
+// available instead of the baseline the file is compiled for. For int and unsigned
+// the division by 3 is a multiply-shift and add_sub_div divides in double (there is
+// no vector integer divide); both are exact, so the results are bit for bit the
+// same as the scalar function templates.
+////////////////////
+
+namespace slide_17_18 {
+
+template <typename T>
+concept batch_arith = std::same_as<T, int> || std::same_as<T, unsigned int> ||
+                      std::same_as<T, float> || std::same_as<T, double>;
+
+template <batch_arith T>
+void add_div_by_3 (std::span<const T> a, std::span<const T> b, std::span<T> out) {
+  batch::add_div_by_3<T>(a, b, out);
+}
+
+template <batch_arith T>
+void add_sub_div (std::span<const T> a, std::span<const T> b, std::span<T> out) {
+  batch::add_sub_div<T>(a, b, out);
+}
+
+} // end namespace
+
+// inputs in a range where neither the scalar nor the batch code overflows, and
+// a - b is never 0
+template <typename T>
+std::pair<std::vector<T>, std::vector<T>> gen_batch_inputs (std::size_t n) {
+  std::mt19937 gen { 7u };
+  std::vector<T> a(n);
+  std::vector<T> b(n);
+  for (std::size_t i {0u}; i < n; ++i) {
+    if constexpr (std::is_floating_point_v<T>) {
+      std::uniform_real_distribution<T> dist { T{-1.0e6}, T{1.0e6} };
+      a[i] = dist(gen);
+      b[i] = (i % 2u == 0u) ? dist(gen) : a[i] + T{0.5};
+    }
+    else {
+      std::uniform_int_distribution<long long> dist { std::is_signed_v<T> ? -1'000'000'000LL : 0LL, 1'000'000'000LL };
+      a[i] = static_cast<T>(dist(gen));
+      b[i] = static_cast<T>(dist(gen));
+      if (a[i] == b[i]) { ++b[i]; }
+    }
+  }
+  return { a, b };
+}
+
+TEMPLATE_TEST_CASE ("Batch function templates match the scalar ones", "[function_template][batch]",
+                    int, unsigned int, float, double) {
+  using namespace slide_17_18;
+
+  for (std::size_t n : { 0u, 1u, 3u, 17u, 1'000u, 1'027u }) { // including scalar tails
+    auto [a, b] = gen_batch_inputs<TestType>(n);
+    std::vector<TestType> out(n);
+    add_div_by_3<TestType>(a, b, out);
+    bool all_equal { true };
+    for (std::size_t i {0u}; i < n; ++i) {
+      all_equal = all_equal && (out[i] == add_div_by_3(a[i], b[i]));
+    }
+    REQUIRE (all_equal);
+    add_sub_div<TestType>(a, b, out);
+    for (std::size_t i {0u}; i < n; ++i) {
+      all_equal = all_equal && (out[i] == add_sub_div(a[i], b[i]));
+    }
+    REQUIRE (all_equal);
+  }
+  std::vector<TestType> small(2);
+  REQUIRE_THROWS_AS (add_div_by_3<TestType>(small, small, std::span<TestType>(small).first(1)), std::range_error);
+}
+
 ////////////////////
 // Slide 21
 ////////////////////
@@ -223,6 +1072,137 @@ TEST_CASE ("Non type template parm intro", "[non_type_template_parm_intro]") {
   delete [] my_arr3;
 }
 
+////////////////////
+// Beyond the slides - arena backed gen_array
+//
+// Every gen_array call is a trip to the global heap, and every array needs its own
+// delete []. The array_arena version carves the arrays out of large blocks instead
+// (a monotonic arena - allocation is a pointer bump), each array starting on a cache
+// line. The handle returned owns the elements (it destroys them, which matters for
+// types such as std::string) and gives access as a std::span with a static extent;
+// the memory itself is reclaimed all at once by reset, which keeps the blocks for
+// reuse. Resetting while handles are still alive is an error, and so is letting a
+// handle outlive the arena (checked by an assert in debug builds).
+////////////////////
+
+constexpr std::size_t cache_line_sz { 64u };
+
+template <typename T, int SZ>
+class arena_array {
+public:
+  arena_array(std::span<T, static_cast<std::size_t>(SZ)> sp, std::size_t* live_cnt) noexcept :
+          m_span(sp), m_live_cnt(live_cnt) { }
+  arena_array(arena_array&& other) noexcept :
+          m_span(other.m_span), m_live_cnt(std::exchange(other.m_live_cnt, nullptr)) { }
+  arena_array& operator= (arena_array&&) = delete;
+  ~arena_array() {
+    if (m_live_cnt != nullptr) {
+      std::destroy(m_span.begin(), m_span.end());
+      --*m_live_cnt;
+    }
+  }
+
+  std::span<T, static_cast<std::size_t>(SZ)> span () const noexcept { return m_span; }
+  T* data () const noexcept { return m_span.data(); }
+  T& operator[] (std::size_t i) const noexcept { return m_span[i]; }
+private:
+  std::span<T, static_cast<std::size_t>(SZ)> m_span;
+  std::size_t* m_live_cnt;
+};
+
+class array_arena {
+public:
+  explicit array_arena (std::size_t block_sz = 1u << 16) : m_block_sz(block_sz) { }
+  array_arena(const array_arena&) = delete;
+  array_arena& operator= (const array_arena&) = delete;
+  // a handle destroys its elements in arena memory and decrements m_live, so none may
+  // outlive the arena
+  ~array_arena() {
+    assert(m_live == 0u && "array_arena destroyed with live arrays");
+    for (auto& b : m_blocks) {
+      ::operator delete(b.mem, std::align_val_t{cache_line_sz});
+    }
+  }
+
+  template <typename T, int SZ>
+  arena_array<T, SZ> gen_array () {
+    static_assert(alignof(T) <= cache_line_sz);
+    auto* mem = allocate(sizeof(T) * static_cast<std::size_t>(SZ));
+    std::uninitialized_default_construct_n(static_cast<T*>(mem), SZ); // same init as new T[SZ]
+    ++m_live;
+    return arena_array<T, SZ>(std::span<T, static_cast<std::size_t>(SZ)>(std::launder(static_cast<T*>(mem)),
+                                                                         static_cast<std::size_t>(SZ)),
+                              &m_live);
+  }
+
+  void reset () {
+    if (m_live != 0u) { throw std::logic_error("arena reset with live arrays"); }
+    m_curr = 0u;
+    m_offset = 0u;
+  }
+  std::size_t live () const noexcept { return m_live; }
+  std::size_t num_blocks () const noexcept { return m_blocks.size(); }
+
+private:
+  void* allocate (std::size_t bytes) {
+    bytes = (bytes + cache_line_sz - 1u) / cache_line_sz * cache_line_sz; // next array starts on a cache line
+    while (m_curr < m_blocks.size() && (m_offset + bytes) > m_blocks[m_curr].sz) { // next block, if any
+      ++m_curr;
+      m_offset = 0u;
+    }
+    if (m_curr == m_blocks.size()) {
+      auto sz = std::max(m_block_sz, bytes);
+      m_blocks.push_back(block { static_cast<std::byte*>(::operator new(sz, std::align_val_t{cache_line_sz})), sz });
+      m_offset = 0u;
+    }
+    auto* p = m_blocks[m_curr].mem + m_offset;
+    m_offset += bytes;
+    return p;
+  }
+
+  struct block {
+    std::byte* mem;
+    std::size_t sz;
+  };
+  std::vector<block> m_blocks;
+  std::size_t m_curr {0u};   // block currently being carved up
+  std::size_t m_offset {0u}; // within the current block
+  std::size_t m_block_sz;
+  std::size_t m_live {0u};
+};
+
+TEST_CASE ("Arena backed gen_array", "[non_type_template_parm_intro][array_arena]") {
+  constexpr std::size_t block_sz { 2048u };
+  // one string more than fits in a block, whatever sizeof(std::string) is (24 bytes
+  // in libc++, 32 in libstdc++), so the strings always need a block of their own
+  constexpr int num_strs { static_cast<int>(block_sz / sizeof(std::string)) + 1 };
+  array_arena arena { block_sz };
+  const double* first_addr { nullptr };
+  {
+    auto arr1 = arena.gen_array<double, 20>();
+    auto arr2 = arena.gen_array<std::string, num_strs>();
+    auto arr3 = arena.gen_array<double, 44>();
+    STATIC_REQUIRE (decltype(arr1.span())::extent == 20u);
+    REQUIRE (reinterpret_cast<std::uintptr_t>(arr1.data()) % cache_line_sz == 0u);
+    REQUIRE (reinterpret_cast<std::uintptr_t>(arr2.data()) % cache_line_sz == 0u);
+    REQUIRE (reinterpret_cast<std::uintptr_t>(arr3.data()) % cache_line_sz == 0u);
+    arr2[num_strs - 1] = "A string long enough to need its own heap allocation";
+    std::span<double, 44> sp = arr3.span();
+    sp[43] = 42.0;
+    REQUIRE (arr3[43] == 42.0);
+    REQUIRE (arena.live() == 3u);
+    REQUIRE_THROWS_AS (arena.reset(), std::logic_error);
+    REQUIRE (arena.num_blocks() == 3u); // the strings filled the second, arr3 started a third
+    first_addr = arr1.data();
+  }
+  REQUIRE (arena.live() == 0u);
+  arena.reset();
+  auto arr4 = arena.gen_array<double, 20>();
+  REQUIRE (arr4.data() == first_addr); // memory is reused after the reset
+  auto big = arena.gen_array<char, 10'000>(); // bigger than any block so far
+  REQUIRE (arena.num_blocks() == 4u);
+}
+
 ////////////////////
 // Slide 24
 ////////////////////
@@ -243,6 +1223,511 @@ TEST_CASE ("Decimal number type, third party", "[decimal_num_type]") {
   REQUIRE (res2 == decimal::decimal<3>{8.111});
 }
 
+////////////////////
+// Beyond the slides - bulk kernels for arrays of decimal::decimal<N>
+//
+// Adding, subtracting, scaling by an integer or dividing by an integer over a whole
+// array, in one pass, with each element computed by the library's own operator - so
+// the results are the scalar operators' results by construction, and nothing here
+// depends on how the library stores a decimal<N>. The loops run in fixed size
+// blocks over restrict pointers, which is what lets GCC vectorize them at -O2 once
+// the operators are inlined: for a decimal<N> that is a scaled 64 bit integer, add
+// and sub become vector adds and subtracts. Dividing by a compile time constant is
+// a multiply and shift per element (64 bit lanes have no vector multiply high).
+// Only operators that the slide templates already use, plus subtraction, are
+// needed: if the library has no multiply by an int, scale doubles and adds, which
+// is exact in fixed point.
+////////////////////
+
+namespace decimal_batch {
+
+template <int N>
+using dec = decimal::decimal<N>;
+
+constexpr std::int64_t pow10 (int n) noexcept {
+  std::int64_t p {1};
+  for (; n > 0; --n) { p *= 10; }
+  return p;
+}
+
+namespace detail {
+
+constexpr std::size_t block_sz { 64u };
+
+// The inner loop has a fixed trip count and the pointers are restrict, which is
+// what lets it vectorize at -O2 (GCC's cheap cost model at -O2 does not vectorize
+// loops that need a scalar remainder or a run time overlap check). out must not
+// overlap a or b; a and b may be the same.
+template <int N, typename Op>
+void loop (const dec<N>* __restrict a, const dec<N>* __restrict b, dec<N>* __restrict out,
+           std::size_t n, Op op) {
+  std::size_t i {0u};
+  for (; (i + block_sz) <= n; i += block_sz) {
+    for (std::size_t j {0u}; j < block_sz; ++j) {
+      out[i + j] = op(a[i + j], b[i + j]);
+    }
+  }
+  for (; i < n; ++i) {
+    out[i] = op(a[i], b[i]);
+  }
+}
+
+template <int N, typename Op>
+void apply (std::span<const dec<N>> a, std::span<const dec<N>> b, std::span<dec<N>> out, Op op) {
+  if (a.size() != b.size() || a.size() != out.size()) {
+    throw std::range_error("decimal batch span sizes differ");
+  }
+  loop<N>(a.data(), b.data(), out.data(), out.size(), op);
+}
+
+} // end namespace
+
+template <int N>
+void add (std::span<const dec<N>> a, std::span<const dec<N>> b, std::span<dec<N>> out) {
+  detail::apply<N>(a, b, out, [] (dec<N> x, dec<N> y) { return x + y; } );
+}
+
+template <int N>
+void sub (std::span<const dec<N>> a, std::span<const dec<N>> b, std::span<dec<N>> out) {
+  detail::apply<N>(a, b, out, [] (dec<N> x, dec<N> y) { return x - y; } );
+}
+
+// the library's x * factor if it has one, else a sum of x, 2x, 4x, ... for the bits
+// of factor
+template <int N>
+void scale (std::span<const dec<N>> a, int factor, std::span<dec<N>> out) {
+  if constexpr (requires (dec<N> x, int f) { { x * f } -> std::convertible_to<dec<N>>; }) {
+    detail::apply<N>(a, a, out, [factor] (dec<N> x, dec<N>) -> dec<N> { return x * factor; } );
+  }
+  else {
+    auto mag = factor < 0 ? 0u - static_cast<unsigned int>(factor) : static_cast<unsigned int>(factor);
+    detail::apply<N>(a, a, out, [mag, neg = factor < 0] (dec<N> x, dec<N>) {
+        dec<N> sum { 0.0 };
+        for (auto bits = mag; bits != 0u; bits >>= 1u, x = x + x) {
+          if (bits & 1u) { sum = sum + x; }
+        }
+        return neg ? dec<N>{0.0} - sum : sum; } );
+  }
+}
+
+// the same expression as the / 3 of the slide 17 function template
+template <int D, int N>
+void div_by (std::span<const dec<N>> a, std::span<dec<N>> out) {
+  static_assert (D != 0);
+  detail::apply<N>(a, a, out, [] (dec<N> x, dec<N>) { return x / D; } );
+}
+
+// the slide 17 function template, one pass over the arrays
+template <int N>
+void add_div_by_3 (std::span<const dec<N>> a, std::span<const dec<N>> b, std::span<dec<N>> out) {
+  detail::apply<N>(a, b, out, [] (dec<N> x, dec<N> y) { return slide_17_18::add_div_by_3(x, y); } );
+}
+
+} // end namespace
+
+// random values, small enough that scaling by up to 1000 does not overflow
+template <int N>
+std::vector<decimal::decimal<N>> gen_random_decimals (std::size_t n, unsigned int seed) {
+  std::mt19937_64 gen { seed };
+  std::uniform_int_distribution<std::int64_t> dist { -1'000'000'000'000LL, 1'000'000'000'000LL };
+  constexpr double one { static_cast<double>(decimal_batch::pow10(N)) };
+  std::vector<decimal::decimal<N>> v;
+  for (std::size_t i {0u}; i < n; ++i) {
+    v.push_back(decimal::decimal<N>{static_cast<double>(dist(gen)) / one});
+  }
+  return v;
+}
+
+TEST_CASE ("Decimal bulk kernels match the scalar operators", "[decimal_num_type][batch]") {
+  using namespace decimal_batch;
+  using dec3 = decimal::decimal<3>;
+
+  auto a = gen_random_decimals<3>(1'003u, 1u); // not a multiple of the block size
+  auto b = gen_random_decimals<3>(1'003u, 2u);
+  std::vector<dec3> out(a.size());
+  auto check = [&] (auto scalar_op) {
+    bool all_equal { true };
+    for (std::size_t i {0u}; i < a.size(); ++i) {
+      all_equal = all_equal && (out[i] == scalar_op(a[i], b[i]));
+    }
+    return all_equal;
+  };
+
+  add<3>(a, b, out);
+  REQUIRE (check([] (dec3 x, dec3 y) { return x + y; } ));
+  sub<3>(a, b, out);
+  REQUIRE (check([] (dec3 x, dec3 y) { return x - y; } ));
+  auto repeated_add = [] (dec3 x, int n) {
+    dec3 sum { 0.0 };
+    for (int i {0}; i < n; ++i) { sum = sum + x; }
+    return sum;
+  };
+  scale<3>(a, 1'000, out);
+  REQUIRE (check([&] (dec3 x, dec3) { return repeated_add(x, 1'000); } ));
+  scale<3>(a, -7, out);
+  REQUIRE (check([&] (dec3 x, dec3) { return dec3{0.0} - repeated_add(x, 7); } ));
+  scale<3>(a, 0, out);
+  REQUIRE (check([] (dec3, dec3) { return dec3{0.0}; } ));
+  div_by<7, 3>(a, out);
+  REQUIRE (check([] (dec3 x, dec3) { return x / 7; } ));
+  add_div_by_3<3>(a, b, out);
+  REQUIRE (check([] (dec3 x, dec3 y) { return slide_17_18::add_div_by_3(x, y); } ));
+
+  std::vector<dec3> a1 { dec3{5.111} };
+  std::vector<dec3> b1 { dec3{19.222} };
+  std::vector<dec3> out1(1u);
+  add_div_by_3<3>(a1, b1, out1);
+  REQUIRE (out1[0] == dec3{8.111});
+  REQUIRE_THROWS_AS (add<3>(a, b1, out), std::range_error);
+}
+
+////////////////////
+// Beyond the slides - parsing and formatting decimal::decimal<N> without a double
+//
+// from_chars and to_chars in the style of <charconv>: no allocation, no locale, no
+// exceptions, and the result (or the error) is reported through the standard
+// from_chars_result / to_chars_result. The digits are read into a 64 bit count of
+// units of 10^-N, so "7.55" is exactly 755 hundredths instead of the nearest double
+// to 7.55. The decimal<N> is then built from the count with the library's own
+// operators: a table holds d * 10^k units for every digit d and place k, made once
+// per N by adding up units (a unit is decimal<N>{1.0} divided by 10, N times), and
+// the value is the sum of one entry per digit. Formatting goes the other way, taking
+// the largest entry that fits out of the value, place by place. Nothing depends on
+// how the library stores a decimal<N>; construction from a double, +, -, / int and
+// < are all that is used.
+// Accepted text is an optional sign, digits, and an optional point followed by
+// digits (at least one digit overall). Digits past the N'th fraction digit are
+// consumed and the value is rounded, half away from zero.
+//
+// parse_column parses a whole buffer of delimited values (e.g. one column of a CSV
+// feed) into a pre-sized span. It does not throw either: the result holds the
+// number of values parsed, where parsing stopped, and a std::errc.
+////////////////////
+
+namespace decimal_io {
+
+namespace detail {
+
+// places 10^0 through 10^18 - an int64 count of units has at most 19 digits
+constexpr std::size_t num_places { 19u };
+
+template <int N>
+struct digit_table {
+  using places = std::array<std::array<decimal::decimal<N>, 10u>, num_places>;
+  places pos; // pos[k][d] is d * 10^k units
+  places neg; // and neg[k][d] is its negation
+};
+
+template <int N>
+const digit_table<N>& digits () {
+  static const digit_table<N> table = [] {
+    digit_table<N> t;
+    decimal::decimal<N> unit { 1.0 };
+    decimal::decimal<N> neg_unit { -1.0 };
+    for (int i {0}; i < N; ++i) {
+      unit = unit / 10;
+      neg_unit = neg_unit / 10;
+    }
+    for (std::size_t k {0u}; k < num_places; ++k) {
+      t.pos[k][0u] = decimal::decimal<N>{0.0};
+      t.neg[k][0u] = decimal::decimal<N>{0.0};
+      for (std::size_t d {1u}; d < 10u; ++d) {
+        t.pos[k][d] = t.pos[k][d - 1u] + unit;
+        t.neg[k][d] = t.neg[k][d - 1u] + neg_unit;
+      }
+      if ((k + 1u) < num_places) { // 10^19 units does not fit
+        unit = t.pos[k][9u] + unit;
+        neg_unit = t.neg[k][9u] + neg_unit;
+      }
+    }
+    return t;
+  }();
+  return table;
+}
+
+// mag units of 10^-N, negated if neg; mag is in range for the count
+template <int N>
+decimal::decimal<N> from_units (std::uint64_t mag, bool neg) {
+  const auto& places = neg ? digits<N>().neg : digits<N>().pos;
+  decimal::decimal<N> value { places[0u][0u] };
+  for (std::size_t k {0u}; mag != 0u; ++k, mag /= 10u) { // the partial sums never overflow
+    value = value + places[k][mag % 10u];
+  }
+  return value;
+}
+
+} // end namespace
+
+// a sign, up to 20 digits, and the point
+constexpr std::size_t max_chars { 22u };
+
+template <int N>
+std::from_chars_result from_chars (const char* first, const char* last, decimal::decimal<N>& value) {
+  static_assert (N >= 0 && N <= 18, "10^N must fit in the 64 bit scaled integer");
+  constexpr std::uint64_t max_mag { std::uint64_t{1u} << 63u }; // magnitude of the int64 minimum
+  auto is_digit = [] (char c) { return c >= '0' && c <= '9'; };
+
+  const char* p = first;
+  bool neg { false };
+  if (p != last && (*p == '-' || *p == '+')) {
+    neg = (*p == '-');
+    ++p;
+  }
+  std::uint64_t mag {0u};
+  bool overflow { false };
+  auto add_digit = [&] (std::uint64_t d) {
+    if (mag > (max_mag - d) / 10u) {
+      overflow = true;
+    }
+    else {
+      mag = mag * 10u + d;
+    }
+  };
+  std::size_t num_digits {0u};
+  for (; p != last && is_digit(*p); ++p, ++num_digits) {
+    add_digit(static_cast<std::uint64_t>(*p - '0'));
+  }
+  int frac {0};
+  bool round_up { false };
+  if (p != last && *p == '.') {
+    ++p;
+    for (; p != last && is_digit(*p); ++p, ++num_digits) {
+      if (frac < N) {
+        add_digit(static_cast<std::uint64_t>(*p - '0'));
+        ++frac;
+      }
+      else if (frac == N) { // only the first dropped digit decides the rounding
+        round_up = (*p >= '5');
+        ++frac;
+      }
+    }
+  }
+  if (num_digits == 0u) {
+    return { first, std::errc::invalid_argument };
+  }
+  for (; frac < N; ++frac) {
+    add_digit(0u);
+  }
+  if (round_up) { // one more unit in the last place
+    overflow = overflow || (mag == max_mag);
+    mag += overflow ? 0u : 1u;
+  }
+  if (overflow || mag > (neg ? max_mag : max_mag - 1u)) {
+    return { p, std::errc::result_out_of_range };
+  }
+  value = detail::from_units<N>(mag, neg);
+  return { p, std::errc{} };
+}
+
+// always writes N fraction digits, e.g. "-0.050" for a decimal<3>
+template <int N>
+std::to_chars_result to_chars (char* first, char* last, decimal::decimal<N> value) {
+  static_assert (N >= 0 && N <= 18, "10^N must fit in the 64 bit scaled integer");
+  const auto& table = detail::digits<N>();
+  bool neg = value < table.pos[0u][0u];
+  const auto& places = neg ? table.neg : table.pos;
+  // whether d * 10^k units can still be taken out of what is left of the value
+  auto fits = [&] (std::size_t k, std::size_t d) {
+    return neg ? !(places[k][d] < value) : !(value < places[k][d]);
+  };
+  constexpr std::size_t units_place { static_cast<std::size_t>(N) };
+  std::array<char, max_chars> buf;
+  char* p = buf.data();
+  if (neg) {
+    *p++ = '-';
+  }
+  std::size_t top { detail::num_places - 1u };
+  while (top > units_place && !fits(top, 1u)) { // no leading zeros
+    --top;
+  }
+  for (std::size_t k { top + 1u }; k-- > 0u; ) {
+    std::size_t d {0u};
+    for (std::size_t i {1u}; i < 10u; ++i) { // the digit is the count of entries that fit, without branches
+      d += fits(k, i) ? 1u : 0u;
+    }
+    value = value - places[k][d];
+    *p++ = static_cast<char>('0' + d);
+    if (k == units_place && N > 0) {
+      *p++ = '.';
+    }
+  }
+  auto len = p - buf.data();
+  if ((last - first) < len) {
+    return { last, std::errc::value_too_large };
+  }
+  return { std::copy(buf.data(), p, first), std::errc{} };
+}
+
+struct parse_column_result {
+  std::size_t count; // values stored in the column
+  const char* ptr; // past the last separator parsed, or at the value or char in error
+  std::errc ec;
+};
+
+// Values are separated by delim or by a line end ("\n" or "\r\n"); one separator
+// after the last value is allowed. The errors are those of from_chars, plus
+// value_too_large when the buffer holds more values than the column.
+template <int N>
+parse_column_result parse_column (std::span<const char> buf, char delim, std::span<decimal::decimal<N>> out) {
+  const char* p = buf.data();
+  const char* last = buf.data() + buf.size();
+  std::size_t cnt {0u};
+  while (p != last) {
+    if (cnt == out.size()) {
+      return { cnt, p, std::errc::value_too_large };
+    }
+    auto [ptr, ec] = from_chars<N>(p, last, out[cnt]);
+    if (ec != std::errc{}) {
+      return { cnt, ptr, ec };
+    }
+    ++cnt;
+    p = ptr;
+    if (p == last) {
+      break;
+    }
+    if (*p == '\r' && (p + 1) != last && *(p + 1) == '\n') {
+      ++p;
+    }
+    if (*p != delim && *p != '\n') {
+      return { cnt, p, std::errc::invalid_argument };
+    }
+    ++p;
+  }
+  return { cnt, p, std::errc{} };
+}
+
+} // end namespace
+
+// "123.45,9.07,..." - prices with two decimal places
+std::string gen_price_text (std::size_t n, char delim) {
+  std::string txt;
+  for (std::size_t i {0u}; i < n; ++i) {
+    auto cents = (i * 2'654'435'761u) % 100'000'000u;
+    txt += std::to_string(cents / 100u);
+    txt += (cents % 100u < 10u) ? ".0" : ".";
+    txt += std::to_string(cents % 100u);
+    txt += delim;
+  }
+  return txt;
+}
+
+TEST_CASE ("Decimal from_chars, to_chars", "[decimal_num_type][charconv]") {
+  using dec2 = decimal::decimal<2>;
+  using dec3 = decimal::decimal<3>;
+
+  auto parse2 = [] (std::string_view sv) {
+    dec2 d;
+    auto res = decimal_io::from_chars<2>(sv.data(), sv.data() + sv.size(), d);
+    return std::pair { res, d };
+  };
+  auto parse_ok = [&] (std::string_view sv) {
+    auto [res, d] = parse2(sv);
+    REQUIRE (res.ec == std::errc{});
+    REQUIRE (res.ptr == sv.data() + sv.size());
+    return d;
+  };
+  auto format = [] (auto d) {
+    std::array<char, decimal_io::max_chars> buf;
+    auto res = decimal_io::to_chars(buf.data(), buf.data() + buf.size(), d);
+    REQUIRE (res.ec == std::errc{});
+    return std::string(buf.data(), res.ptr);
+  };
+
+  SECTION ("Parse") {
+    REQUIRE (parse_ok("123.45") == dec2{123.45});
+    REQUIRE (parse_ok("-0.5") == dec2{-0.5});
+    REQUIRE (parse_ok("+7") == dec2{7.0});
+    REQUIRE (parse_ok(".5") == dec2{0.5});
+    REQUIRE (parse_ok("5.") == dec2{5.0});
+    REQUIRE (parse_ok("0") == dec2{0.0});
+    REQUIRE (parse_ok("1.234") == dec2{1.23});
+    REQUIRE (parse_ok("1.235") == dec2{1.24}); // rounded half away from zero
+    REQUIRE (parse_ok("-1.2351") == dec2{-1.24});
+    REQUIRE (parse_ok("0.999") == dec2{1.0});
+    REQUIRE (parse_ok("7.55") == dec2{7.55}); // same as constructing from the double
+    REQUIRE (parse_ok("-12.34") == dec2{12.5} - dec2{24.84});
+  }
+  SECTION ("Parse errors") {
+    std::string_view bad { "abc" };
+    auto [res, d] = parse2(bad);
+    REQUIRE (res.ec == std::errc::invalid_argument);
+    REQUIRE (res.ptr == bad.data());
+    REQUIRE (parse2("-").first.ec == std::errc::invalid_argument);
+    REQUIRE (parse2(".").first.ec == std::errc::invalid_argument);
+    REQUIRE (parse2("92233720368547758.08").first.ec == std::errc::result_out_of_range);
+    REQUIRE (parse2("92233720368547758.075").first.ec == std::errc::result_out_of_range); // by rounding
+    REQUIRE (parse2("99999999999999999999999").first.ec == std::errc::result_out_of_range);
+    std::string_view trailing { "12.5x" };
+    auto [res2, d2] = parse2(trailing);
+    REQUIRE (res2.ec == std::errc{});
+    REQUIRE (res2.ptr == trailing.data() + 4); // stops at the first char that is not part of the value
+  }
+  SECTION ("Format") {
+    REQUIRE (format(dec3{-5.111}) == "-5.111");
+    REQUIRE (format(dec2{7.0}) == "7.00");
+    REQUIRE (format(dec2{0.0}) == "0.00");
+    REQUIRE (format(dec3{-0.005}) == "-0.005");
+    REQUIRE (format(dec3{-0.05}) == "-0.050");
+    REQUIRE (format(dec3{1'000.5}) == "1000.500");
+    // the ends of the range, 64 bit counts of hundredths
+    REQUIRE (format(parse_ok("-92233720368547758.08")) == "-92233720368547758.08");
+    REQUIRE (format(parse_ok("92233720368547758.07")) == "92233720368547758.07");
+    std::array<char, 3> small; // "7.55" needs 4
+    auto res = decimal_io::to_chars(small.data(), small.data() + small.size(), dec2{7.55});
+    REQUIRE (res.ec == std::errc::value_too_large);
+  }
+  SECTION ("Round trip") {
+    auto vals = gen_random_decimals<3>(1'000u, 3u);
+    bool all_equal { true };
+    for (auto v : vals) {
+      auto s = format(v);
+      dec3 d;
+      decimal_io::from_chars<3>(s.data(), s.data() + s.size(), d);
+      all_equal = all_equal && (d == v);
+    }
+    REQUIRE (all_equal);
+  }
+}
+
+TEST_CASE ("Decimal parse_column", "[decimal_num_type][charconv]") {
+  using dec2 = decimal::decimal<2>;
+  std::vector<dec2> col(3u);
+
+  std::string_view csv { "1.25,2.50,-3.75\r\n" };
+  auto res = decimal_io::parse_column<2>(csv, ',', col);
+  REQUIRE (res.ec == std::errc{});
+  REQUIRE (res.count == 3u);
+  REQUIRE (res.ptr == csv.data() + csv.size());
+  REQUIRE (col[0] == dec2{1.25});
+  REQUIRE (col[1] == dec2{2.5});
+  REQUIRE (col[2] == dec2{-3.75});
+  std::string_view lines { "4\n5" };
+  REQUIRE (decimal_io::parse_column<2>(lines, ',', col).count == 2u);
+  REQUIRE (col[1] == dec2{5.0});
+
+  auto parse_err = [&col] (std::string_view sv) {
+    auto r = decimal_io::parse_column<2>(sv, ',', col);
+    return std::tuple { r.ec, r.count, r.ptr - sv.data() };
+  };
+  REQUIRE (parse_err("1,2,3,4") == std::tuple { std::errc::value_too_large, 3u, 6 });
+  REQUIRE (parse_err("1,,2") == std::tuple { std::errc::invalid_argument, 1u, 2 });
+  REQUIRE (parse_err("1;2") == std::tuple { std::errc::invalid_argument, 1u, 1 });
+  REQUIRE (std::get<0>(parse_err("1,99999999999999999999")) == std::errc::result_out_of_range);
+
+  // same values as parsing each one with std::stod and constructing from the double
+  auto txt = gen_price_text(1'000u, ',');
+  std::vector<dec2> big(1'000u);
+  REQUIRE (decimal_io::parse_column<2>(txt, ',', big).count == 1'000u);
+  bool all_equal { true };
+  std::size_t pos {0u};
+  for (auto v : big) {
+    auto next = txt.find(',', pos);
+    all_equal = all_equal && (v == dec2{std::stod(txt.substr(pos, next - pos))});
+    pos = next + 1u;
+  }
+  REQUIRE (all_equal);
+}
+
 ////////////////////
 // Slide 25
 ////////////////////
@@ -323,6 +1808,7 @@ void math_func_1 (big_math_capable auto a) {
 
 template <big_math_capable T>
     T math_func_2(T a, T b) {
+  TRACE_SCOPE("math_func_2");
   using namespace slide_26;
 
   return add_div_by_3 (a, b);
@@ -342,6 +1828,7 @@ TEST_CASE ("Concept, function templates using the concept", "[concept]") {
 
 template <typename Ctr, typename F>
 void traverse(Ctr& container, F func) {
+  TRACE_SCOPE("traverse");
   for (auto& elem : container) {
     func(elem);
   }
@@ -402,6 +1889,342 @@ TEST_CASE ("Traverse function", "[traverse]") {
 }
 
 
+////////////////////
+// Beyond the slides - traverse with an execution policy
+//
+// The policy types are tags, in the same spirit as the iterator tags on slide 7.
+// With par_policy, a contiguous container is split into chunks that start on cache
+// line boundaries (so two threads never write to the same cache line), each chunk
+// is traversed on its own thread, and the inner loop is a plain pointer loop that
+// the compiler can vectorize. Node based containers such as std::list are traversed
+// serially.
+//
+// Functors with state need defined semantics when the elements are split between
+// threads. Every chunk calls the same functor object, so only a functor with no
+// state at all is accepted as is: a plain function, or an empty class such as a
+// lambda without captures. Being callable as const is not enough, since a lambda
+// that captures by reference can still write through the reference, and those
+// writes would race. A functor type that only reads shared data (e.g. a lambda
+// capturing a const table) can opt in by specializing par_safe_func; anything it
+// writes is then the caller's responsibility, as are globals written by a function.
+// A functor with state can still be used if it provides a chunk_skip(f, n) function
+// that advances a copy of the functor as if it had been called n times; each
+// chunk then starts with a copy of the functor fixed up for the elements before
+// it, and the result is the same as a serial traverse. Anything else is rejected
+// at compile time.
+////////////////////
+
+struct seq_policy { };
+struct par_policy {
+  unsigned threads { std::max(1u, std::thread::hardware_concurrency()) };
+};
+
+constexpr std::size_t min_traverse_chunk { 1u << 14 }; // elements, smaller chunks are not worth a thread
+
+// specialize as true for a functor type whose calls can safely run on several
+// threads at once, sharing the one object
+template <typename F>
+inline constexpr bool par_safe_func { false };
+
+template <typename F, typename T>
+concept stateless_func = std::invocable<const F&, T&> &&
+                         (std::is_empty_v<F> || std::is_pointer_v<F> || par_safe_func<F>);
+
+template <typename F, typename T>
+concept chunk_skippable_func = std::invocable<F&, T&> && std::copy_constructible<F> &&
+                               requires (F& f, std::size_t n) { chunk_skip(f, n); };
+
+template <typename Ctr, typename F>
+void traverse (seq_policy, Ctr& container, F func) {
+  traverse(container, func);
+}
+
+template <typename Ctr, typename F>
+  requires (!std::ranges::contiguous_range<Ctr> ||
+            stateless_func<F, std::ranges::range_value_t<Ctr>> ||
+            chunk_skippable_func<F, std::ranges::range_value_t<Ctr>>)
+void traverse (par_policy pol, Ctr& container, F func) {
+  TRACE_SCOPE("traverse, par_policy");
+  if constexpr (!std::ranges::contiguous_range<Ctr>) {
+    traverse(container, func);
+  }
+  else {
+    using T = std::ranges::range_value_t<Ctr>;
+    auto* data = std::ranges::data(container);
+    auto n = static_cast<std::size_t>(std::ranges::size(container));
+    std::size_t per_line = (cache_line_sz % sizeof(T) == 0u) ? cache_line_sz / sizeof(T) : 1u;
+    // elements before the first cache line boundary go in with the first chunk
+    std::size_t head = (per_line > 1u) ?
+          ((cache_line_sz - reinterpret_cast<std::uintptr_t>(data) % cache_line_sz) % cache_line_sz) / sizeof(T) : 0u;
+    auto chunk = std::max(min_traverse_chunk, (n / std::max(1u, pol.threads)) + 1u);
+    chunk = ((chunk + per_line - 1u) / per_line) * per_line;
+
+    auto run_chunk = [data, &func] (std::size_t first, std::size_t last) {
+      if constexpr (stateless_func<F, T>) {
+        const F& f = func;
+        for (auto* p = data + first; p != data + last; ++p) { f(*p); }
+      }
+      else {
+        F f { func };
+        chunk_skip(f, first);
+        for (auto* p = data + first; p != data + last; ++p) { f(*p); }
+      }
+    };
+    std::vector<std::future<void>> futs;
+    std::size_t first {0u};
+    std::size_t last = std::min(n, head + chunk);
+    while (last < n) {
+      futs.push_back(std::async(std::launch::async, run_chunk, first, last));
+      first = last;
+      last = std::min(n, last + chunk);
+    }
+    run_chunk(first, last); // last chunk on the calling thread
+    for (auto& fut : futs) { fut.get(); }
+  }
+}
+
+// add_x adds an increasing amount to each element, so a chunk that starts n
+// elements in must start with x advanced by n
+void chunk_skip (add_x& f, std::size_t n) {
+  f.x += static_cast<int>(n);
+}
+
+template <typename Ctr, typename F>
+concept par_traversable = requires (Ctr& c, F f) { traverse(par_policy{}, c, f); };
+
+// holds its data, but only reads it, so it is safe to share between the chunks
+struct scale_by_table {
+  std::array<int, 2> factors;
+  void operator() (int& x) const { x *= factors[0] * factors[1]; }
+};
+template <>
+inline constexpr bool par_safe_func<scale_by_table> { true };
+
+TEST_CASE ("Traverse with an execution policy", "[traverse][par_traverse]") {
+  std::vector<int> v(90'000);
+  std::iota(v.begin(), v.end(), -45'000); // squares still fit in an int
+  auto expected = v;
+
+  SECTION ("Stateless function, several thread counts") {
+    traverse(expected, square_val);
+    for (unsigned threads : { 1u, 2u, 3u, 8u }) {
+      auto w = v;
+      traverse(par_policy{threads}, w, square_val);
+      REQUIRE (w == expected);
+    }
+    auto w = v;
+    traverse(seq_policy{}, w, [] (int& x) { x = x * x; } );
+    REQUIRE (w == expected);
+  }
+
+  SECTION ("Stateful add_x, fixed up per chunk") {
+    traverse(expected, add_x{42});
+    traverse(par_policy{4u}, v, add_x{42});
+    REQUIRE (v == expected);
+  }
+
+  SECTION ("Node based container and string") {
+    std::list<int> lst { 2, 4, 6, 8 };
+    traverse(par_policy{4u}, lst, add_x{11});
+    REQUIRE_THAT(lst, Catch::Matchers::RangeEquals(std::vector<int>{13, 16, 19, 22}));
+    std::string str { "Howdy"};
+    traverse(par_policy{4u}, str, incr_char);
+    REQUIRE(str == std::string("Ipxez"));
+  }
+
+  SECTION ("Stateful functor without chunk_skip is rejected for contiguous containers") {
+    auto counter = [cnt = 0] (int& x) mutable { x += cnt++; };
+    STATIC_REQUIRE (!par_traversable<std::vector<int>, decltype(counter)>);
+    STATIC_REQUIRE (par_traversable<std::list<int>, decltype(counter)>);
+    STATIC_REQUIRE (par_traversable<std::vector<int>, add_x>);
+  }
+
+  SECTION ("Lambda capturing by reference is rejected unless it opts in") {
+    long long total {0};
+    auto accum = [&total] (int& x) { total += x; }; // const callable, but would race
+    STATIC_REQUIRE (!par_traversable<std::vector<int>, decltype(accum)>);
+    STATIC_REQUIRE (par_traversable<std::vector<int>, decltype([] (int& x) { x += 1; })>);
+  }
+
+  SECTION ("Opted in functor that reads shared data") {
+    std::vector<int> w(40'000, 1);
+    traverse(par_policy{4u}, w, scale_by_table{ std::array<int, 2>{ 3, 5 } });
+    REQUIRE (std::all_of(w.begin(), w.end(), [] (int x) { return x == 15; } ));
+  }
+}
+
+////////////////////
+// Beyond the slides - fused pipeline stages for traverse
+//
+// Several traverse passes over the same container each walk the whole container
+// again. A pipeline of map, filter and take stages is instead fused into a single
+// function object, which traverse calls once per element, so there is one loop
+// over the data and no intermediate containers. Each stage wraps the stage after
+// it, and returns false once no more elements are wanted (take), which ends the
+// loop early. The source can be any range, including a coroutine generator for
+// data that is streamed rather than stored.
+////////////////////
+
+namespace lazy {
+
+template <typename F>
+struct map_stage {
+  F func;
+  template <typename Next>
+  auto bind (Next next) const {
+    return [f = func, next] (auto&& val) mutable { return next(f(std::forward<decltype(val)>(val))); };
+  }
+};
+
+template <typename P>
+struct filter_stage {
+  P pred;
+  template <typename Next>
+  auto bind (Next next) const {
+    return [p = pred, next] (auto&& val) mutable {
+      return p(val) ? next(std::forward<decltype(val)>(val)) : true;
+    };
+  }
+};
+
+struct take_stage {
+  std::size_t count;
+  template <typename Next>
+  auto bind (Next next) const {
+    return [left = count, next] (auto&& val) mutable {
+      if (left == 0u) { return false; }
+      --left;
+      return next(std::forward<decltype(val)>(val)) && left > 0u;
+    };
+  }
+};
+
+template <typename... Stages>
+struct pipeline {
+  std::tuple<Stages...> stages;
+
+  template <std::size_t I = 0u, typename Next>
+  auto bind (Next next) const {
+    if constexpr (I == sizeof...(Stages)) { return next; }
+    else { return std::get<I>(stages).bind(bind<I + 1u>(next)); }
+  }
+};
+
+template <typename F>
+pipeline<map_stage<F>> map (F func) { return { { map_stage<F>{func} } }; }
+template <typename P>
+pipeline<filter_stage<P>> filter (P pred) { return { { filter_stage<P>{pred} } }; }
+inline pipeline<take_stage> take (std::size_t count) { return { { take_stage{count} } }; }
+
+template <typename... S1, typename... S2>
+pipeline<S1..., S2...> operator| (const pipeline<S1...>& a, const pipeline<S2...>& b) {
+  return { std::tuple_cat(a.stages, b.stages) };
+}
+
+// minimal C++ 20 coroutine generator (std::generator is C++ 23), an input range
+template <typename T>
+class generator {
+public:
+  struct promise_type {
+    std::optional<T> value;
+    generator get_return_object () {
+      return generator { std::coroutine_handle<promise_type>::from_promise(*this) };
+    }
+    std::suspend_always initial_suspend () noexcept { return { }; }
+    std::suspend_always final_suspend () noexcept { return { }; }
+    std::suspend_always yield_value (T val) { value = std::move(val); return { }; }
+    void return_void () noexcept { }
+    void unhandled_exception () { throw; }
+  };
+
+  class iterator {
+  public:
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    iterator() = default;
+    explicit iterator (std::coroutine_handle<promise_type> h) : m_hdl(h) { }
+    T& operator* () const { return *m_hdl.promise().value; }
+    iterator& operator++ () { m_hdl.resume(); return *this; }
+    void operator++ (int) { ++*this; }
+    bool operator== (std::default_sentinel_t) const { return m_hdl.done(); }
+  private:
+    std::coroutine_handle<promise_type> m_hdl { };
+  };
+
+  explicit generator (std::coroutine_handle<promise_type> h) : m_hdl(h) { }
+  generator (generator&& other) noexcept : m_hdl(std::exchange(other.m_hdl, { })) { }
+  generator& operator= (generator&&) = delete;
+  ~generator() { if (m_hdl) { m_hdl.destroy(); } }
+
+  iterator begin () { m_hdl.resume(); return iterator { m_hdl }; }
+  std::default_sentinel_t end () const noexcept { return { }; }
+private:
+  std::coroutine_handle<promise_type> m_hdl;
+};
+
+} // end namespace
+
+// the sink receives each value that makes it through the pipeline
+template <typename Rng, typename... Stages, typename Sink>
+void traverse (Rng&& source, const lazy::pipeline<Stages...>& pl, Sink sink) {
+  auto fused = pl.bind([&sink] (auto&& val) { sink(std::forward<decltype(val)>(val)); return true; } );
+  for (auto&& elem : source) {
+    if (!fused(elem)) { break; }
+  }
+}
+
+lazy::generator<unsigned int> count_from (unsigned int start) { // never ends
+  for (unsigned int i {start}; ; ++i) {
+    co_yield i;
+  }
+}
+
+TEST_CASE ("Traverse with fused pipeline stages", "[traverse][pipeline]") {
+  std::vector<int> v { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+  std::vector<int> out;
+  auto collect = [&out] (int x) { out.push_back(x); };
+
+  SECTION ("Map, filter, take in one pass") {
+    int calls {0};
+    auto pl = lazy::map([&calls] (int x) { ++calls; return x * x; }) |
+              lazy::filter([] (int x) { return x % 2 == 0; }) |
+              lazy::take(3u);
+    traverse(v, pl, collect);
+    REQUIRE_THAT(out, Catch::Matchers::RangeEquals(std::vector<int>{4, 16, 36}));
+    REQUIRE (calls == 6); // stopped as soon as the third value was taken
+  }
+
+  SECTION ("Same result as separate traverse passes") {
+    auto w = v;
+    traverse(w, square_val);
+    traverse(w, add_x{1});
+    int sum {0};
+    traverse(w, [&sum] (int& x) { if (x % 3 == 0) { sum += x; } } );
+
+    int fused_sum {0};
+    traverse(v, lazy::map([] (int x) { return x * x; }) |
+                lazy::map([i = 0] (int x) mutable { return x + (++i); }) |
+                lazy::filter([] (int x) { return x % 3 == 0; }),
+             [&fused_sum] (int x) { fused_sum += x; } );
+    REQUIRE (fused_sum == sum);
+    REQUIRE_THAT(v, Catch::Matchers::RangeEquals(std::vector<int>{ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 }));
+  }
+
+  SECTION ("Take of zero, empty source") {
+    traverse(v, lazy::take(0u), collect);
+    REQUIRE (out.empty());
+    traverse(std::vector<int>{ }, lazy::map([] (int x) { return x; }), collect);
+    REQUIRE (out.empty());
+  }
+
+  SECTION ("Streaming source from a coroutine generator") {
+    std::vector<unsigned int> gen_out;
+    traverse(count_from(1u), lazy::filter([] (unsigned int x) { return x % 5u == 0u; }) | lazy::take(4u),
+             [&gen_out] (unsigned int x) { gen_out.push_back(x); } );
+    REQUIRE_THAT(gen_out, Catch::Matchers::RangeEquals(std::vector<unsigned int>{5u, 10u, 15u, 20u}));
+  }
+}
+
 ////////////////////
 // Slides 36 thru 38
 ////////////////////
@@ -440,6 +2263,453 @@ TEST_CASE ("Lambda, closure", "[lambda_closure]") {
 
 }
 
+TEST_CASE ("Projection sort of person", "[lambda_closure][key_index_sort]") {
+  std::vector<person> v { { "Nathan", 23u }, { "Lou", 77u }, { "Cliff", 35u }, { "Bozo", 35u } };
+
+  SECTION ("By name, through sort_alg") {
+    sort_alg(v.begin(), v.end(), random_access_iterator_tag{}, &person::name);
+    REQUIRE (v[0].name == std::string("Bozo"));
+    REQUIRE (v[1].name == std::string("Cliff"));
+    REQUIRE (v[2].name == std::string("Lou"));
+    REQUIRE (v[3].name == std::string("Nathan"));
+  }
+
+  SECTION ("By age, descending, stable") {
+    key_index_sort(v.begin(), v.end(), &person::age, std::greater<>{});
+    REQUIRE (v[0].name == std::string("Lou"));
+    REQUIRE (v[1].name == std::string("Cliff"));
+    REQUIRE (v[2].name == std::string("Bozo"));
+    REQUIRE (v[3].name == std::string("Nathan"));
+  }
+
+  SECTION ("Larger range, against std::stable_sort") {
+    std::vector<person> people;
+    for (unsigned int i {0u}; i < 2'000u; ++i) {
+      people.push_back(person { std::to_string((i * 7919u) % 2'003u), i % 13u });
+    }
+    auto expected = people;
+    std::stable_sort(expected.begin(), expected.end(),
+                     [] (const person& a, const person& b) { return a.name < b.name; } );
+    sort_alg(people.begin(), people.end(), random_access_iterator_tag{},
+             [] (const person& p) -> const std::string& { return p.name; } );
+    REQUIRE (std::equal(people.begin(), people.end(), expected.begin(),
+                        [] (const person& a, const person& b) { return a.name == b.name && a.age == b.age; } ));
+  }
+}
+
+TEST_CASE ("String prefix sort of person by name", "[lambda_closure][string_prefix_sort]") {
+
+  SECTION ("Prefix is big endian and unsigned") {
+    REQUIRE (string_prefix("") == 0u);
+    REQUIRE (string_prefix("a") == 0x6100000000000000ull);
+    REQUIRE (string_prefix("abcdefghij") == 0x6162636465666768ull);
+    REQUIRE (string_prefix("\xff") > string_prefix("zzzzzzzz"));
+  }
+
+  SECTION ("Shared prefixes, short strings and high bytes, against std::stable_sort") {
+    std::vector<person> v { { "Stephanopoulos", 1u }, { "Stephanie", 2u }, { "Stephanopoulis", 3u },
+                            { "Steph", 4u }, { "", 5u }, { "Stephanopoulos", 6u }, { "\xe9lise", 7u },
+                            { "Stephani", 8u }, { std::string("Steph\0", 6u), 9u }, { "Zed", 10u } };
+    auto expected = v;
+    std::stable_sort(expected.begin(), expected.end(),
+                     [] (const person& a, const person& b) { return a.name < b.name; } );
+    sort_alg(v.begin(), v.end(), random_access_iterator_tag{}, &person::name);
+    REQUIRE (std::equal(v.begin(), v.end(), expected.begin(),
+                        [] (const person& a, const person& b) { return a.name == b.name && a.age == b.age; } ));
+  }
+}
+
+TEST_CASE ("Radix sort of person by age", "[lambda_closure][radix_sort]") {
+  std::vector<person> v { { "Cliff", 35u }, { "Lou", 77u }, { "Nathan", 23u }, { "Bozo", 35u } };
+  sort_alg(v.begin(), v.end(), random_access_iterator_tag{}, &person::age);
+  REQUIRE (v[0].name == std::string("Nathan"));
+  REQUIRE (v[1].name == std::string("Cliff")); // stable, Cliff was before Bozo
+  REQUIRE (v[2].name == std::string("Bozo"));
+  REQUIRE (v[3].age == 77u);
+  sort_alg(v.begin(), v.end(), random_access_iterator_tag{}, [] (const person& p) { return -static_cast<int>(p.age); });
+  REQUIRE (v[0].name == std::string("Lou"));
+}
+
+////////////////////
+// Beyond the slides - benchmarks
+//
+// The benchmark test cases are hidden (the "[.]" tag), so they do not run as part
+// of the unit tests; run them with e.g. intro_generic_programming_test "[benchmark]"
+////////////////////
+
+constexpr std::size_t bench_sz { 1'000'000u };
+
+std::vector<int> gen_random_ints (std::size_t n) {
+  std::mt19937 gen { 42u };
+  std::uniform_int_distribution<int> dist;
+  std::vector<int> v(n);
+  std::generate(v.begin(), v.end(), [&] { return dist(gen); } );
+  return v;
+}
+
+std::vector<person> gen_random_people (std::size_t n) {
+  std::mt19937 gen { 42u };
+  std::uniform_int_distribution<int> len_dist { 3, 20 };
+  std::uniform_int_distribution<int> char_dist { 'a', 'z' };
+  std::uniform_int_distribution<unsigned int> age_dist { 0u, 120u };
+  std::vector<person> v(n);
+  for (auto& p : v) {
+    p.name.resize(static_cast<std::size_t>(len_dist(gen)));
+    std::generate(p.name.begin(), p.name.end(), [&] { return static_cast<char>(char_dist(gen)); } );
+    p.age = age_dist(gen);
+  }
+  return v;
+}
+
+// the original slide 7 code path, copying into a temporary list and sorting that
+template <typename Iter, typename Compare, typename Alloc = std::allocator<std::iter_value_t<Iter>>>
+void copy_to_list_sort (Iter begin, Iter end, Compare comp, Alloc alloc = Alloc{}) {
+  std::list<std::iter_value_t<Iter>, Alloc> lst(begin, end, alloc);
+  lst.sort(comp);
+}
+
+TEST_CASE ("Benchmark bidirectional sort_alg", "[.][benchmark][bidi_sort]") {
+  auto by_age = [] (const person& a, const person& b) { return a.age < b.age; };
+  auto ints = gen_random_ints(bench_sz);
+  auto people = gen_random_people(bench_sz);
+  std::list<int> int_lst (ints.begin(), ints.end());
+  std::list<person> person_lst (people.begin(), people.end());
+
+  BENCHMARK_ADVANCED ("copy to list, list<int>")(Catch::Benchmark::Chronometer meter) {
+    meter.measure([&] { copy_to_list_sort(int_lst.begin(), int_lst.end(), std::less<>{}); } );
+  };
+  BENCHMARK_ADVANCED ("buffered merge sort, list<int>")(Catch::Benchmark::Chronometer meter) {
+    std::vector<std::list<int>> lsts(static_cast<std::size_t>(meter.runs()), int_lst);
+    meter.measure([&] (int i) {
+      auto& l = lsts[static_cast<std::size_t>(i)];
+      sort_alg(l.begin(), l.end(), bidirectional_iterator_tag{});
+    } );
+  };
+  BENCHMARK_ADVANCED ("in place rotation merge (the fallback), list<int>")(Catch::Benchmark::Chronometer meter) {
+    std::vector<std::list<int>> lsts(static_cast<std::size_t>(meter.runs()), int_lst);
+    meter.measure([&] (int i) {
+      auto& l = lsts[static_cast<std::size_t>(i)];
+      merge_sort_bidi(l.begin(), l.end(), std::ssize(l), static_cast<int*>(nullptr), std::less<>{});
+    } );
+  };
+  BENCHMARK_ADVANCED ("copy to list, list<person> by age")(Catch::Benchmark::Chronometer meter) {
+    meter.measure([&] { copy_to_list_sort(person_lst.begin(), person_lst.end(), by_age); } );
+  };
+  BENCHMARK_ADVANCED ("buffered merge sort, list<person> by age")(Catch::Benchmark::Chronometer meter) {
+    std::vector<std::list<person>> lsts(static_cast<std::size_t>(meter.runs()), person_lst);
+    meter.measure([&] (int i) {
+      auto& l = lsts[static_cast<std::size_t>(i)];
+      sort_alg(l.begin(), l.end(), bidirectional_iterator_tag{}, by_age);
+    } );
+  };
+
+  std::list<int, counting_alloc<int>> cnt_lst (ints.begin(), ints.end());
+  alloc_count = 0;
+  copy_to_list_sort(cnt_lst.begin(), cnt_lst.end(), std::less<>{}, counting_alloc<int>{});
+  auto copy_allocs = alloc_count;
+  alloc_count = 0;
+  sort_alg(cnt_lst.begin(), cnt_lst.end(), bidirectional_iterator_tag{});
+  INFO ("List node allocations, copy to list: " << copy_allocs << ", sort_alg: " << alloc_count);
+  REQUIRE (alloc_count == 0u);
+  REQUIRE (std::is_sorted(cnt_lst.begin(), cnt_lst.end()));
+}
+
+TEST_CASE ("Benchmark random access sort_alg", "[.][benchmark][par_sort]") {
+  auto ints = gen_random_ints(10u * bench_sz);
+
+  auto bench_sort = [&ints] (std::string name, auto sort_func) {
+    BENCHMARK_ADVANCED (std::move(name))(Catch::Benchmark::Chronometer meter) {
+      std::vector<std::vector<int>> vs(static_cast<std::size_t>(meter.runs()), ints);
+      meter.measure([&] (int i) {
+        auto& v = vs[static_cast<std::size_t>(i)];
+        sort_func(v.begin(), v.end());
+      } );
+    };
+  };
+
+  bench_sort("std::sort, 10M ints", [] (auto b, auto e) { std::sort(b, e); } );
+#if defined(BENCH_STD_EXECUTION_PAR)
+  bench_sort("std::sort(par), 10M ints", [] (auto b, auto e) { std::sort(std::execution::par, b, e); } );
+#endif
+  for (unsigned threads : { 1u, 2u, 4u, 8u }) {
+    ws_pool pool { threads };
+    bench_sort("par_sort, " + std::to_string(threads) + " thread pool, 10M ints",
+               [&pool] (auto b, auto e) { par_sort(b, e, std::less<>{}, pool); } );
+  }
+}
+
+TEST_CASE ("Benchmark radix sort_alg", "[.][benchmark][radix_sort]") {
+  auto ints = gen_random_ints(10u * bench_sz);
+  auto people = gen_random_people(bench_sz);
+
+  auto bench_sort = [] (std::string name, const auto& src, auto sort_func) {
+    BENCHMARK_ADVANCED (std::move(name))(Catch::Benchmark::Chronometer meter) {
+      std::vector vs(static_cast<std::size_t>(meter.runs()), src);
+      meter.measure([&] (int i) {
+        auto& v = vs[static_cast<std::size_t>(i)];
+        sort_func(v.begin(), v.end());
+      } );
+    };
+  };
+
+  bench_sort("std::sort, 10M ints", ints, [] (auto b, auto e) { std::sort(b, e); } );
+  bench_sort("radix sort_alg, 10M ints", ints,
+             [] (auto b, auto e) { sort_alg(b, e, random_access_iterator_tag{}); } );
+  bench_sort("std::sort, 1M person by age", people,
+             [] (auto b, auto e) { std::sort(b, e, [] (const person& x, const person& y) { return x.age < y.age; } ); } );
+  bench_sort("radix sort_alg, 1M person by age", people,
+             [] (auto b, auto e) { sort_alg(b, e, random_access_iterator_tag{}, &person::age); } );
+}
+
+// a person with a name that counts its heap allocations
+using counted_string = std::basic_string<char, std::char_traits<char>, counting_alloc<char>>;
+struct counted_person {
+  counted_string name;
+  unsigned int age;
+};
+
+TEST_CASE ("Benchmark projection sort", "[.][benchmark][key_index_sort]") {
+  std::vector<counted_person> people;
+  for (auto& p : gen_random_people(bench_sz)) {
+    people.push_back(counted_person { counted_string(p.name.begin(), p.name.end()), p.age });
+  }
+  auto by_val_name = [] (auto a, auto b) { return a.name < b.name; }; // as in the "Lambda, closure" test
+  auto by_val_age = [] (auto a, auto b) { return a.age < b.age; };
+
+  auto bench_sort = [&people] (std::string name, auto sort_func) {
+    BENCHMARK_ADVANCED (std::move(name))(Catch::Benchmark::Chronometer meter) {
+      std::vector vs(static_cast<std::size_t>(meter.runs()), people);
+      meter.measure([&] (int i) {
+        auto& v = vs[static_cast<std::size_t>(i)];
+        sort_func(v.begin(), v.end());
+      } );
+    };
+  };
+  auto count_allocs = [&people] (auto sort_func) {
+    auto v = people;
+    alloc_count = 0u;
+    sort_func(v.begin(), v.end());
+    return alloc_count;
+  };
+
+  auto lam_name = [&] (auto b, auto e) { std::sort(b, e, by_val_name); };
+  auto proj_name = [] (auto b, auto e) { sort_alg(b, e, random_access_iterator_tag{}, &counted_person::name); };
+  auto lam_age = [&] (auto b, auto e) { std::sort(b, e, by_val_age); };
+  auto proj_age = [] (auto b, auto e) { key_index_sort(b, e, &counted_person::age); };
+
+  bench_sort("by value lambda, 1M person by name", lam_name);
+  bench_sort("projection, 1M person by name", proj_name);
+  bench_sort("by value lambda, 1M person by age", lam_age);
+  bench_sort("projection (key index), 1M person by age", proj_age);
+
+  auto lam_allocs = count_allocs(lam_name);
+  auto proj_allocs = count_allocs(proj_name);
+  INFO ("Name string allocations, by value lambda: " << lam_allocs << ", projection: " << proj_allocs);
+  REQUIRE (proj_allocs == 0u);
+  REQUIRE (lam_allocs > 0u);
+}
+
+TEST_CASE ("Benchmark string prefix sort", "[.][benchmark][string_prefix_sort]") {
+  auto people = gen_random_people(bench_sz);
+
+  auto bench_sort = [&people] (std::string name, auto sort_func) {
+    BENCHMARK_ADVANCED (std::move(name))(Catch::Benchmark::Chronometer meter) {
+      std::vector vs(static_cast<std::size_t>(meter.runs()), people);
+      meter.measure([&] (int i) {
+        auto& v = vs[static_cast<std::size_t>(i)];
+        sort_func(v.begin(), v.end());
+      } );
+    };
+  };
+
+  bench_sort("std::sort, 1M person by name",
+             [] (auto b, auto e) { std::sort(b, e, [] (const person& x, const person& y) { return x.name < y.name; } ); } );
+  bench_sort("key index sort, string compares, 1M person by name", [] (auto b, auto e) {
+               key_index_sort(b, e, &person::name, [] (const auto& x, const auto& y) { return x < y; } ); } );
+  bench_sort("string prefix sort, 1M person by name",
+             [] (auto b, auto e) { sort_alg(b, e, random_access_iterator_tag{}, &person::name); } );
+}
+
+TEST_CASE ("Benchmark traverse with an execution policy", "[.][benchmark][par_traverse]") {
+  std::vector<int> v(10u * bench_sz);
+  std::iota(v.begin(), v.end(), 0);
+  auto sq = [] (int& x) { x = x * x; };
+
+  BENCHMARK ("traverse, 10M ints") {
+    traverse(v, sq);
+    return v[0];
+  };
+  for (unsigned threads {1u}; threads <= par_policy{}.threads; threads *= 2u) {
+    BENCHMARK ("traverse(par_policy), " + std::to_string(threads) + " threads, 10M ints") {
+      traverse(par_policy{threads}, v, sq);
+      return v[0];
+    };
+  }
+}
+
+TEST_CASE ("Benchmark fused pipeline against separate traverse passes", "[.][benchmark][pipeline]") {
+  std::vector<unsigned int> v(100u * bench_sz); // 400 MB
+  std::iota(v.begin(), v.end(), 0u);
+
+  BENCHMARK ("three traverse passes, 100M unsigned ints") {
+    traverse(v, [] (unsigned int& x) { x = x * x; } );
+    traverse(v, [] (unsigned int& x) { x += 1u; } );
+    unsigned int sum {0u};
+    traverse(v, [&sum] (unsigned int& x) { if (x % 3u == 0u) { sum += x; } } );
+    return sum;
+  };
+  BENCHMARK ("fused pipeline, 100M unsigned ints") {
+    unsigned int sum {0u};
+    traverse(v, lazy::map([] (unsigned int x) { return x * x; }) |
+                lazy::map([] (unsigned int x) { return x + 1u; }) |
+                lazy::filter([] (unsigned int x) { return x % 3u == 0u; }),
+             [&sum] (unsigned int x) { sum += x; } );
+    return sum;
+  };
+}
+
+TEST_CASE ("Benchmark arena backed gen_array", "[.][benchmark][array_arena]") {
+  constexpr int num_arrays { 1'000 };
+  array_arena arena;
+
+  BENCHMARK ("gen_array<double, 20>, 1000 arrays") {
+    std::vector<double*> arrs;
+    for (int i {0}; i < num_arrays; ++i) { arrs.push_back(gen_array<double, 20>()); }
+    for (auto* a : arrs) { delete [] a; }
+    return arrs.size();
+  };
+  BENCHMARK ("array_arena<double, 20>, 1000 arrays") {
+    std::vector<arena_array<double, 20>> arrs;
+    arrs.reserve(num_arrays);
+    for (int i {0}; i < num_arrays; ++i) { arrs.push_back(arena.gen_array<double, 20>()); }
+    arrs.clear();
+    arena.reset();
+    return arrs.size();
+  };
+  BENCHMARK ("gen_array<std::string, 66>, 1000 arrays") {
+    std::vector<std::string*> arrs;
+    for (int i {0}; i < num_arrays; ++i) { arrs.push_back(gen_array<std::string, 66>()); }
+    for (auto* a : arrs) { delete [] a; }
+    return arrs.size();
+  };
+  BENCHMARK ("array_arena<std::string, 66>, 1000 arrays") {
+    std::vector<arena_array<std::string, 66>> arrs;
+    arrs.reserve(num_arrays);
+    for (int i {0}; i < num_arrays; ++i) { arrs.push_back(arena.gen_array<std::string, 66>()); }
+    arrs.clear();
+    arena.reset();
+    return arrs.size();
+  };
+}
+
+TEMPLATE_TEST_CASE ("Benchmark batch function templates", "[.][benchmark][batch]",
+                    int, unsigned int, float, double) {
+  using namespace slide_17_18;
+  auto [a, b] = gen_batch_inputs<TestType>(bench_sz);
+  std::vector<TestType> out(bench_sz);
+
+  BENCHMARK ("scalar add_div_by_3 loop, 1M") {
+    for (std::size_t i {0u}; i < a.size(); ++i) { out[i] = add_div_by_3(a[i], b[i]); }
+    return out[0];
+  };
+  BENCHMARK ("batch add_div_by_3, 1M") {
+    add_div_by_3<TestType>(a, b, out);
+    return out[0];
+  };
+  BENCHMARK ("scalar add_sub_div loop, 1M") {
+    for (std::size_t i {0u}; i < a.size(); ++i) { out[i] = add_sub_div(a[i], b[i]); }
+    return out[0];
+  };
+  BENCHMARK ("batch add_sub_div, 1M") {
+    add_sub_div<TestType>(a, b, out);
+    return out[0];
+  };
+}
+
+TEST_CASE ("Benchmark decimal bulk kernels", "[.][benchmark][decimal_num_type][batch]") {
+  using dec3 = decimal::decimal<3>;
+
+  // 16K elements stay in cache, 1M elements measure memory bandwidth as much as the kernels
+  for (std::size_t n : { std::size_t{16'384u}, bench_sz }) {
+    auto a = gen_random_decimals<3>(n, 1u);
+    auto b = gen_random_decimals<3>(n, 2u);
+    std::vector<dec3> out(n);
+    std::string sz { n == bench_sz ? ", 1M decimal<3>" : ", 16K decimal<3>" };
+
+    BENCHMARK ("per element operator+" + sz) {
+      for (std::size_t i {0u}; i < a.size(); ++i) { out[i] = a[i] + b[i]; }
+      return out[0];
+    };
+    BENCHMARK ("decimal_batch::add" + sz) {
+      decimal_batch::add<3>(a, b, out);
+      return out[0];
+    };
+    BENCHMARK ("decimal_batch::scale by 1000" + sz) {
+      decimal_batch::scale<3>(a, 1'000, out);
+      return out[0];
+    };
+    BENCHMARK ("per element generic add_div_by_3" + sz) {
+      for (std::size_t i {0u}; i < a.size(); ++i) { out[i] = slide_17_18::add_div_by_3(a[i], b[i]); }
+      return out[0];
+    };
+    BENCHMARK ("decimal_batch::add_div_by_3" + sz) {
+      decimal_batch::add_div_by_3<3>(a, b, out);
+      return out[0];
+    };
+  }
+}
+
+TEST_CASE ("Benchmark decimal parse and format", "[.][benchmark][decimal_num_type][charconv]") {
+  using dec2 = decimal::decimal<2>;
+  constexpr std::size_t num_vals { 100'000u };
+  auto txt = gen_price_text(num_vals, ',');
+  std::vector<dec2> col(num_vals);
+
+  BENCHMARK ("std::stod, decimal<2> from double, 100K prices") {
+    std::size_t pos {0u};
+    for (auto& v : col) {
+      auto next = txt.find(',', pos);
+      v = dec2{std::stod(txt.substr(pos, next - pos))};
+      pos = next + 1u;
+    }
+    return col[0];
+  };
+  BENCHMARK ("std::from_chars double, decimal<2> from double, 100K prices") {
+    const char* p = txt.data();
+    for (auto& v : col) {
+      double d {};
+      p = std::from_chars(p, txt.data() + txt.size(), d).ptr + 1;
+      v = dec2{d};
+    }
+    return col[0];
+  };
+  BENCHMARK ("decimal_io::parse_column, 100K prices") {
+    return decimal_io::parse_column<2>(txt, ',', col).count;
+  };
+
+  std::vector<double> dbls; // the same prices, for formatting through a double
+  for (std::size_t pos {0u}; pos < txt.size(); ) {
+    auto next = txt.find(',', pos);
+    dbls.push_back(std::stod(txt.substr(pos, next - pos)));
+    pos = next + 1u;
+  }
+  std::string out(num_vals * decimal_io::max_chars, ' ');
+  BENCHMARK ("std::to_chars double fixed 2, 100K prices") {
+    char* p = out.data();
+    for (auto d : dbls) {
+      p = std::to_chars(p, out.data() + out.size(), d, std::chars_format::fixed, 2).ptr;
+    }
+    return p - out.data();
+  };
+  BENCHMARK ("decimal_io::to_chars, 100K prices") {
+    char* p = out.data();
+    for (auto v : col) {
+      p = decimal_io::to_chars(p, out.data() + out.size(), v).ptr;
+    }
+    return p - out.data();
+  };
+}
+
 ////////////////////
 // Slides 40, 41
 ////////////////////
@@ -473,6 +2743,201 @@ TEST_CASE ("Pair, typle", "[pair_tuple]") {
 
 }
 
+////////////////////
+// Beyond the slides - structure of arrays
+//
+// A std::vector<two_items<std::string, unsigned int>> stores each name next to its
+// age, so a scan of the ages brings every name (32 bytes of std::string) through the
+// cache as well. soa_vector stores each field in its own std::vector, so a scan of
+// one field touches only that field's memory, and the column can be handed to a
+// batch (SIMD) kernel as a contiguous span.
+//
+// Indexing returns a proxy of references instead of a record. The proxy is a
+// std::tuple of references, so std::get<I> and structured bindings work; for two
+// fields it also has first and second, like two_items and std::pair.
+////////////////////
+
+template <typename... Ts>
+struct soa_ref : std::tuple<Ts&...> {
+  using std::tuple<Ts&...>::tuple;
+};
+
+template <typename T1, typename T2>
+struct soa_ref<T1, T2> : std::tuple<T1&, T2&> {
+  T1& first;
+  T2& second;
+  soa_ref (T1& a, T2& b) : std::tuple<T1&, T2&>(a, b), first(a), second(b) { }
+};
+
+template <typename... Ts>
+struct std::tuple_size<soa_ref<Ts...>> : std::integral_constant<std::size_t, sizeof...(Ts)> { };
+
+template <std::size_t I, typename... Ts>
+struct std::tuple_element<I, soa_ref<Ts...>> : std::tuple_element<I, std::tuple<Ts&...>> { };
+
+template <typename... Ts>
+class soa_vector {
+  std::tuple<std::vector<Ts>...> m_cols;
+
+  template <typename Self, std::size_t... Is>
+  static auto make_ref (Self& self, std::size_t i, std::index_sequence<Is...>) {
+    using ref_t = std::conditional_t<std::is_const_v<Self>, soa_ref<const Ts...>, soa_ref<Ts...>>;
+    return ref_t { std::get<Is>(self.m_cols)[i]... };
+  }
+
+  template <typename Self>
+  class iter {
+    Self* m_vec {nullptr};
+    std::size_t m_idx {0u};
+  public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = decltype(make_ref(std::declval<Self&>(), 0u, std::index_sequence_for<Ts...>{}));
+    iter () = default;
+    iter (Self* vec, std::size_t idx) : m_vec(vec), m_idx(idx) { }
+    value_type operator* () const { return (*m_vec)[m_idx]; }
+    iter& operator++ () { ++m_idx; return *this; }
+    iter operator++ (int) { auto tmp = *this; ++m_idx; return tmp; }
+    bool operator== (const iter&) const = default;
+  };
+
+public:
+  using reference = soa_ref<Ts...>;
+  using const_reference = soa_ref<const Ts...>;
+
+  std::size_t size () const noexcept { return std::get<0>(m_cols).size(); }
+  bool empty () const noexcept { return size() == 0u; }
+
+  void reserve (std::size_t n) {
+    std::apply([n] (auto&... col) { (col.reserve(n), ...); }, m_cols);
+  }
+  void clear () noexcept {
+    std::apply([] (auto&... col) { (col.clear(), ...); }, m_cols);
+  }
+
+  // if one of the columns throws, the columns already appended to are trimmed back
+  // (with erase, since resize would need default constructible column types)
+  void push_back (Ts... vals) {
+    std::size_t sz = size();
+    try {
+      [&]<std::size_t... Is> (std::index_sequence<Is...>) {
+        (std::get<Is>(m_cols).push_back(std::move(vals)), ...);
+      } (std::index_sequence_for<Ts...>{});
+    }
+    catch (...) {
+      std::apply([sz] (auto&... col) {
+          (col.erase(col.begin() + static_cast<std::ptrdiff_t>(std::min(col.size(), sz)), col.end()), ...); }, m_cols);
+      throw;
+    }
+  }
+
+  reference operator[] (std::size_t i) { return make_ref(*this, i, std::index_sequence_for<Ts...>{}); }
+  const_reference operator[] (std::size_t i) const { return make_ref(*this, i, std::index_sequence_for<Ts...>{}); }
+
+  reference at (std::size_t i) {
+    if (i >= size()) {
+      throw std::range_error("soa_vector index out of range");
+    }
+    return (*this)[i];
+  }
+
+  template <std::size_t I>
+  auto column () noexcept { return std::span(std::get<I>(m_cols)); }
+  template <std::size_t I>
+  auto column () const noexcept { return std::span(std::get<I>(m_cols)); }
+
+  auto begin () { return iter<soa_vector> { this, 0u }; }
+  auto end () { return iter<soa_vector> { this, size() }; }
+  auto begin () const { return iter<const soa_vector> { this, 0u }; }
+  auto end () const { return iter<const soa_vector> { this, size() }; }
+};
+
+TEST_CASE ("Structure of arrays", "[pair_tuple][soa]") {
+  soa_vector<std::string, unsigned int> people;
+  people.push_back("Cliff", 36u);
+  people.push_back("Lou", 66u);
+  REQUIRE (people.size() == 2u);
+  REQUIRE (people[0].first == std::string("Cliff"));
+  REQUIRE (people[0].second == 36u);
+  REQUIRE (std::get<0>(people[1]) == std::string("Lou"));
+
+  people[1].second += 1u; // Lou just aged a year, through the proxy
+  REQUIRE (people.column<1>()[1] == 67u);
+  auto [name, age] = people[0];
+  age = 37u; // structured bindings refer to the columns
+  REQUIRE (people[0].second == 37u);
+  REQUIRE (name == std::string("Cliff"));
+
+  auto ages = people.column<1>();
+  REQUIRE (std::accumulate(ages.begin(), ages.end(), 0u) == 104u);
+  std::vector<std::string> names;
+  for (auto p : people) {
+    names.push_back(p.first);
+  }
+  REQUIRE_THAT (names, Catch::Matchers::RangeEquals(std::vector<std::string>{ "Cliff", "Lou" }));
+  REQUIRE_THROWS_AS (people.at(2u), std::range_error);
+
+  const auto& cpeople = people;
+  STATIC_REQUIRE (std::is_same_v<decltype(cpeople[0].first), const std::string&>);
+  STATIC_REQUIRE (std::is_same_v<decltype(cpeople.column<1>()), std::span<const unsigned int>>);
+
+  soa_vector<int, std::string, double> recs; // tuple style, any number of fields
+  recs.push_back(42, "Howdy!", 44.0);
+  REQUIRE (std::get<0>(recs[0]) == 42);
+  REQUIRE (std::get<1>(recs[0]) == std::string("Howdy!"));
+  REQUIRE (std::get<2>(recs[0]) == 44.0);
+  recs.clear();
+  REQUIRE (recs.empty());
+
+  struct picky { // no default constructor, and moving a negative value throws
+    explicit picky (int v) : val(v) { }
+    picky (picky&& other) : val(other.val) {
+      if (val < 0) { throw std::runtime_error("picky"); }
+    }
+    picky& operator= (picky&&) = default;
+    int val;
+  };
+  soa_vector<picky, picky> pickies;
+  pickies.push_back(picky{1}, picky{2});
+  REQUIRE_THROWS_AS (pickies.push_back(picky{3}, picky{-4}), std::runtime_error);
+  REQUIRE (pickies.size() == 1u);
+  REQUIRE (pickies.column<0>().size() == 1u);
+  REQUIRE (pickies.column<1>()[0].val == 2);
+}
+
+TEST_CASE ("Benchmark structure of arrays", "[.][benchmark][soa]") {
+  auto src = gen_random_people(bench_sz);
+  std::vector<two_items<std::string, unsigned int>> aos;
+  soa_vector<std::string, unsigned int> soa;
+  soa.reserve(bench_sz);
+  for (const auto& p : src) {
+    aos.push_back({ p.name, p.age });
+    soa.push_back(p.name, p.age);
+  }
+
+  BENCHMARK ("vector<two_items<string, unsigned>>, sum of ages, 1M") {
+    unsigned long long sum {0u};
+    for (const auto& p : aos) { sum += p.second; }
+    return sum;
+  };
+  BENCHMARK ("soa_vector<string, unsigned>, sum of ages through proxies, 1M") {
+    unsigned long long sum {0u};
+    for (auto p : soa) { sum += p.second; }
+    return sum;
+  };
+  BENCHMARK ("soa_vector<string, unsigned>, sum of ages column, 1M") {
+    unsigned long long sum {0u};
+    for (auto a : soa.column<1>()) { sum += a; }
+    return sum;
+  };
+  BENCHMARK ("vector<two_items<string, unsigned>>, count age > 60, 1M") {
+    return std::count_if(aos.begin(), aos.end(), [] (const auto& p) { return p.second > 60u; } );
+  };
+  BENCHMARK ("soa_vector<string, unsigned>, count age > 60 column, 1M") {
+    auto ages = soa.column<1>();
+    return std::count_if(ages.begin(), ages.end(), [] (unsigned int a) { return a > 60u; } );
+  };
+}
+
 ////////////////////
 // Slides 42, 43
 ////////////////////
@@ -516,6 +2981,244 @@ TEST_CASE ("Optional type", "[optional_type]") {
   REQUIRE (!d);
 }
 
+////////////////////
+// Beyond the slides - compact optional, optional column
+//
+// my_opt and std::optional store a bool next to the value, so for an 8 byte T the
+// padding doubles the size. compact_optional instead marks "empty" with a value of T
+// that is never a real value (NaN, the int minimum, ...), so it is exactly the size
+// of T. The sentinel is given as a policy type rather than a non-type template parm
+// since a double non-type template parm is not yet supported everywhere (see below).
+//
+// optional_column keeps a whole column of optional values as a dense array of T (an
+// absent element holds T{}) plus a separate presence bitmap, one bit per element.
+// Counting the present elements is a popcount per 64 elements, and iterating over
+// them skips 64 absent elements at a time.
+////////////////////
+
+template <typename T>
+struct nan_sentinel {
+  static constexpr T value () noexcept { return std::numeric_limits<T>::quiet_NaN(); }
+  static bool is_sentinel (const T& v) noexcept { return std::isnan(v); } // any NaN
+};
+
+// the most negative value - for floating point types that is lowest(), since min()
+// is the smallest positive (normalized) value
+template <typename T>
+struct min_sentinel {
+  static constexpr T value () noexcept { return std::numeric_limits<T>::lowest(); }
+  static bool is_sentinel (const T& v) noexcept { return v == value(); }
+};
+
+template <typename T, T V>
+struct value_sentinel {
+  static constexpr T value () noexcept { return V; }
+  static bool is_sentinel (const T& v) noexcept { return v == V; }
+};
+
+template <typename T, typename Sentinel>
+class compact_optional {
+  T val { Sentinel::value() };
+public:
+  compact_optional () = default;
+  compact_optional (const T& v) : val(v) {
+    if (Sentinel::is_sentinel(v)) {
+      throw std::range_error("compact_optional value is the empty sentinel");
+    }
+  }
+  T& operator* () { return val; }
+  const T& operator* () const { return val; }
+  T* operator-> () { return &val; }
+  const T* operator-> () const { return &val; }
+  bool has_value () const noexcept { return !Sentinel::is_sentinel(val); }
+  explicit operator bool () const noexcept { return has_value(); }
+  T value_or (const T& dflt) const { return has_value() ? val : dflt; }
+  void reset () noexcept { val = Sentinel::value(); }
+};
+
+template <typename T>
+class optional_column {
+  std::vector<T> m_vals;
+  std::vector<std::uint64_t> m_present;
+
+  static constexpr std::size_t word_bits { 64u };
+  static std::uint64_t bit (std::size_t i) noexcept { return std::uint64_t{1u} << (i % word_bits); }
+
+public:
+  std::size_t size () const noexcept { return m_vals.size(); }
+
+  void reserve (std::size_t n) {
+    m_vals.reserve(n);
+    m_present.reserve((n + word_bits - 1u) / word_bits);
+  }
+
+  void push_back (const T& v) {
+    push_back_empty();
+    m_vals.back() = v;
+    m_present.back() |= bit(size() - 1u);
+  }
+  void push_back (const std::optional<T>& v) {
+    v ? push_back(*v) : push_back_empty();
+  }
+  void push_back_empty () {
+    if (size() % word_bits == 0u) {
+      m_present.push_back(0u);
+    }
+    m_vals.emplace_back();
+  }
+
+  bool has_value (std::size_t i) const noexcept { return (m_present[i / word_bits] & bit(i)) != 0u; }
+  std::optional<T> operator[] (std::size_t i) const {
+    return has_value(i) ? std::optional<T>(m_vals[i]) : std::nullopt;
+  }
+  void set (std::size_t i, const T& v) {
+    m_vals[i] = v;
+    m_present[i / word_bits] |= bit(i);
+  }
+  void reset (std::size_t i) {
+    m_vals[i] = T{};
+    m_present[i / word_bits] &= ~bit(i);
+  }
+
+  std::size_t count () const noexcept {
+    std::size_t cnt {0u};
+    for (auto w : m_present) {
+      cnt += static_cast<std::size_t>(std::popcount(w));
+    }
+    return cnt;
+  }
+
+  // f(index, value) for each present element, in index order
+  template <typename F>
+  void for_each_present (F f) const {
+    for (std::size_t w {0u}; w < m_present.size(); ++w) {
+      for (auto bits = m_present[w]; bits != 0u; bits &= bits - 1u) {
+        auto i = w * word_bits + static_cast<std::size_t>(std::countr_zero(bits));
+        f(i, m_vals[i]);
+      }
+    }
+  }
+
+  // all of the values, absent ones are T{}
+  std::span<const T> values () const noexcept { return m_vals; }
+};
+
+using compact_dbl = compact_optional<double, nan_sentinel<double>>;
+compact_dbl compact_func (bool return_value) {
+  return return_value ? compact_dbl(44.0) : compact_dbl();
+}
+
+TEST_CASE ("Compact optional", "[optional_type]") {
+  STATIC_REQUIRE (sizeof(compact_dbl) == sizeof(double));
+  STATIC_REQUIRE (sizeof(compact_optional<int, min_sentinel<int>>) == sizeof(int));
+  STATIC_REQUIRE (sizeof(std::optional<double>) == 2u * sizeof(double));
+
+  // same behavior as my_opt and std::optional above
+  auto a = compact_func(true);
+  REQUIRE (a);
+  REQUIRE (*a == 44.0);
+  auto b = compact_func(false);
+  REQUIRE (!b);
+  REQUIRE (b.value_or(1.0) == 1.0);
+  a.reset();
+  REQUIRE (!a);
+
+  compact_optional<int, min_sentinel<int>> i { 42 };
+  REQUIRE (i.has_value());
+  *i += 1;
+  REQUIRE (*i == 43);
+  REQUIRE_THROWS_AS ((compact_optional<int, min_sentinel<int>>{ std::numeric_limits<int>::min() }), std::range_error);
+  compact_optional<double, min_sentinel<double>> tiny { std::numeric_limits<double>::min() }; // a real value
+  REQUIRE (tiny.has_value());
+  REQUIRE_THROWS_AS ((compact_optional<double, min_sentinel<double>>{ std::numeric_limits<double>::lowest() }), std::range_error);
+  compact_optional<unsigned int, value_sentinel<unsigned int, 0xFFFFFFFFu>> u;
+  REQUIRE (!u);
+}
+
+TEST_CASE ("Optional column", "[optional_type]") {
+  optional_column<double> col;
+  for (std::size_t i {0u}; i < 200u; ++i) {
+    if (i % 3u == 0u) {
+      col.push_back(static_cast<double>(i));
+    }
+    else {
+      col.push_back(std::optional<double>{});
+    }
+  }
+  REQUIRE (col.size() == 200u);
+  REQUIRE (col.count() == 67u);
+  REQUIRE (col[3] == 3.0);
+  REQUIRE (!col[4]);
+  REQUIRE (col.values()[4] == 0.0);
+
+  col.set(4u, 4.0);
+  col.reset(3u);
+  REQUIRE (col.count() == 67u);
+  REQUIRE (col[4] == 4.0);
+  REQUIRE (!col.has_value(3u));
+
+  std::vector<std::size_t> idx;
+  double sum {0.0};
+  col.for_each_present([&] (std::size_t i, double v) {
+    idx.push_back(i);
+    sum += v;
+  } );
+  REQUIRE (idx.size() == 67u);
+  REQUIRE (idx[0] == 0u);
+  REQUIRE (idx[1] == 4u);
+  REQUIRE (idx.back() == 198u);
+  REQUIRE (sum == 6'633.0 - 3.0 + 4.0); // 0 + 3 + ... + 198, minus 3, plus 4
+}
+
+TEST_CASE ("Benchmark compact optional, optional column", "[.][benchmark][optional_type]") {
+  std::mt19937 gen { 42u };
+  std::bernoulli_distribution present { 0.5 };
+  std::vector<std::optional<double>> std_opts;
+  std::vector<compact_dbl> compact_opts;
+  optional_column<double> col;
+  col.reserve(bench_sz);
+  for (std::size_t i {0u}; i < bench_sz; ++i) {
+    auto v = present(gen) ? std::optional<double>(static_cast<double>(i)) : std::nullopt;
+    std_opts.push_back(v);
+    compact_opts.push_back(v ? compact_dbl(*v) : compact_dbl());
+    col.push_back(v);
+  }
+
+  BENCHMARK ("vector<std::optional<double>>, count present, 1M") {
+    std::size_t cnt {0u};
+    for (const auto& o : std_opts) { cnt += o.has_value(); }
+    return cnt;
+  };
+  BENCHMARK ("vector<compact_optional<double>>, count present, 1M") {
+    std::size_t cnt {0u};
+    for (const auto& o : compact_opts) { cnt += o.has_value(); }
+    return cnt;
+  };
+  BENCHMARK ("optional_column<double>, count present, 1M") {
+    return col.count();
+  };
+  BENCHMARK ("vector<std::optional<double>>, sum present, 1M") {
+    double sum {0.0};
+    for (const auto& o : std_opts) { sum += o.value_or(0.0); }
+    return sum;
+  };
+  BENCHMARK ("vector<compact_optional<double>>, sum present, 1M") {
+    double sum {0.0};
+    for (const auto& o : compact_opts) { sum += o.value_or(0.0); }
+    return sum;
+  };
+  BENCHMARK ("optional_column<double>, sum present, 1M") {
+    double sum {0.0};
+    col.for_each_present([&sum] (std::size_t, double v) { sum += v; } );
+    return sum;
+  };
+  BENCHMARK ("optional_column<double>, sum of values span, 1M") {
+    double sum {0.0}; // absent elements hold 0.0, so they can be summed too
+    for (auto v : col.values()) { sum += v; }
+    return sum;
+  };
+}
+
 ////////////////////
 // Slides 44, 45
 ////////////////////
@@ -549,3 +3252,211 @@ TEST_CASE ("Non-type template parm", "[non-type-template-parm]") {
   */
 
 }
+
+////////////////////
+// Beyond the slides - sorting networks for small std::array and static extent spans
+//
+// std::sort on 4 or 8 elements spends most of its time in introsort's dispatch and
+// in branches that mispredict on random data. A sorting network is a fixed sequence
+// of compare-exchange steps chosen at compile time from N alone, so with N a template
+// parm the whole sort is straight line code with constant indices. For arithmetic
+// (trivially copyable) types each compare-exchange is a select, which compiles to
+// min / max instructions without branches.
+//
+// The networks are Batcher's odd-even merge sort, generated at compile time, which
+// is the smallest possible network for N up to 8 (e.g. 5 steps for 4, 19 for 8).
+// For 16 a known 60 step network is used instead of Batcher's 63. Above
+// max_network_sz the network gets too long and static_sort calls std::sort.
+////////////////////
+
+namespace sort_net {
+
+constexpr std::size_t max_network_sz { 32u };
+
+using cmp_pair = std::pair<std::uint8_t, std::uint8_t>;
+
+// calls f(i, j) for each compare-exchange of Batcher's network, in order; for N
+// that is not a power of 2, the steps that touch an index past N are dropped
+template <typename F>
+constexpr void batcher_steps (std::size_t n, F f) {
+  std::size_t p2 {1u};
+  while (p2 < n) {
+    p2 *= 2u;
+  }
+  for (std::size_t p {1u}; p < p2; p *= 2u) {
+    for (std::size_t k {p}; k >= 1u; k /= 2u) {
+      for (std::size_t j {k % p}; (j + k) < p2; j += 2u * k) {
+        for (std::size_t i {0u}; i < std::min(k, p2 - j - k); ++i) {
+          if ((i + j) / (p * 2u) == (i + j + k) / (p * 2u) && (i + j + k) < n) {
+            f(i + j, i + j + k);
+          }
+        }
+      }
+    }
+  }
+}
+
+template <std::size_t N>
+consteval std::size_t batcher_size () {
+  std::size_t cnt {0u};
+  batcher_steps(N, [&cnt] (std::size_t, std::size_t) { ++cnt; } );
+  return cnt;
+}
+
+template <std::size_t N>
+constexpr auto network = [] {
+  std::array<cmp_pair, batcher_size<N>()> net {};
+  std::size_t idx {0u};
+  batcher_steps(N, [&] (std::size_t i, std::size_t j) {
+    net[idx++] = { static_cast<std::uint8_t>(i), static_cast<std::uint8_t>(j) };
+  } );
+  return net;
+} ();
+
+template <>
+constexpr auto network<16u> = std::array<cmp_pair, 60u> { {
+  {0,13}, {1,12}, {2,15}, {3,14}, {4,8}, {5,6}, {7,11}, {9,10},
+  {0,5}, {1,7}, {2,9}, {3,4}, {6,13}, {8,14}, {10,15}, {11,12},
+  {0,1}, {2,3}, {4,5}, {6,8}, {7,9}, {10,11}, {12,13}, {14,15},
+  {0,2}, {1,3}, {4,10}, {5,11}, {6,7}, {8,9}, {12,14}, {13,15},
+  {1,2}, {3,12}, {4,6}, {5,7}, {8,10}, {9,11}, {13,14},
+  {1,4}, {2,6}, {5,8}, {7,10}, {9,13}, {11,14},
+  {2,4}, {3,6}, {9,12}, {11,13},
+  {3,5}, {6,8}, {7,9}, {10,12},
+  {3,4}, {5,6}, {7,8}, {9,10}, {11,12},
+  {6,7}, {8,9}
+} };
+
+template <typename T, typename Compare>
+constexpr void compare_exchange (T& a, T& b, Compare comp) {
+  if constexpr (std::is_trivially_copyable_v<T>) { // selects instead of a branch
+    bool swap = comp(b, a);
+    T lo = swap ? b : a;
+    T hi = swap ? a : b;
+    a = lo;
+    b = hi;
+  }
+  else {
+    if (comp(b, a)) {
+      std::swap(a, b);
+    }
+  }
+}
+
+} // end namespace
+
+template <typename T, std::size_t N, typename Compare = std::less<>>
+  requires (N != std::dynamic_extent)
+constexpr void static_sort (std::span<T, N> sp, Compare comp = Compare{}) {
+  if constexpr (N > sort_net::max_network_sz) {
+    std::sort(sp.begin(), sp.end(), comp);
+  }
+  else if constexpr (N > 1u) {
+    constexpr auto& net = sort_net::network<N>;
+    [&]<std::size_t... Is> (std::index_sequence<Is...>) {
+      (sort_net::compare_exchange(sp[net[Is].first], sp[net[Is].second], comp), ...);
+    } (std::make_index_sequence<net.size()>{});
+  }
+}
+
+template <typename T, std::size_t N, typename Compare = std::less<>>
+constexpr void static_sort (std::array<T, N>& arr, Compare comp = Compare{}) {
+  static_sort(std::span<T, N>(arr), comp);
+}
+
+constexpr std::array<int, 4> sorted_at_compile_time = [] {
+  std::array<int, 4> arr { 46, 20, 44, 77 };
+  static_sort(arr);
+  return arr;
+} ();
+
+// every input of 0s and 1s (the 0-1 principle: a network that sorts all of
+// them sorts every input)
+template <std::size_t N>
+bool sorts_all_zero_one () {
+  bool all_sorted { true };
+  for (std::uint32_t bits {0u}; bits < (std::uint32_t{1u} << N); ++bits) {
+    std::array<int, N> arr;
+    for (std::size_t i {0u}; i < N; ++i) {
+      arr[i] = static_cast<int>((bits >> i) & 1u);
+    }
+    static_sort(arr);
+    all_sorted = all_sorted && std::is_sorted(arr.begin(), arr.end());
+  }
+  return all_sorted;
+}
+
+TEST_CASE ("Sorting networks", "[non-type-template-parm][static_sort]") {
+  STATIC_REQUIRE (sorted_at_compile_time == std::array<int, 4>{ 20, 44, 46, 77 });
+  STATIC_REQUIRE (sort_net::network<4u>.size() == 5u);
+  STATIC_REQUIRE (sort_net::network<8u>.size() == 19u);
+  STATIC_REQUIRE (sort_net::network<16u>.size() == 60u);
+
+  std::array<int, 4> my_array { 46, 20, 44, 77 }; // as in the test above
+  static_sort(my_array);
+  REQUIRE_THAT(my_array, Catch::Matchers::RangeEquals(std::vector<int>{ 20, 44, 46, 77 }));
+
+  REQUIRE ([]<std::size_t... Ns> (std::index_sequence<Ns...>) {
+    return (sorts_all_zero_one<Ns + 2u>() && ...);
+  } (std::make_index_sequence<15u>{})); // 2 through 16
+
+  std::mt19937 gen { 42u };
+  std::uniform_int_distribution<int> dist { -20, 20 }; // plenty of duplicates
+  auto check_random = [&] <std::size_t N> (std::integral_constant<std::size_t, N>) {
+    bool all_equal { true };
+    for (int r {0}; r < 200; ++r) {
+      std::array<int, N> arr;
+      std::generate(arr.begin(), arr.end(), [&] { return dist(gen); } );
+      auto expected = arr;
+      std::sort(expected.begin(), expected.end(), std::greater<>{});
+      static_sort(arr, std::greater<>{});
+      all_equal = all_equal && (arr == expected);
+    }
+    return all_equal;
+  };
+  REQUIRE (check_random(std::integral_constant<std::size_t, 7u>{}));
+  REQUIRE (check_random(std::integral_constant<std::size_t, 25u>{}));
+  REQUIRE (check_random(std::integral_constant<std::size_t, 40u>{})); // std::sort
+
+  std::vector<double> vec { 3.5, -1.0, 2.25, 0.0, 9.0, 1.5 };
+  static_sort(std::span<double, 4>(vec.data() + 1, 4u)); // sorts just those 4
+  REQUIRE_THAT(vec, Catch::Matchers::RangeEquals(std::vector<double>{ 3.5, -1.0, 0.0, 2.25, 9.0, 1.5 }));
+
+  std::array<std::string, 5> strs { "delta", "alpha", "echo", "charlie", "bravo" };
+  static_sort(strs); // not trivially copyable, compare and swap
+  REQUIRE_THAT(strs, Catch::Matchers::RangeEquals(
+                       std::vector<std::string>{ "alpha", "bravo", "charlie", "delta", "echo" }));
+}
+
+template <std::size_t N>
+void bench_static_sort () {
+  constexpr std::size_t num_arrays { 1'000'000u / N };
+  std::mt19937 gen { 42u };
+  std::uniform_int_distribution<int> dist;
+  std::vector<std::array<int, N>> src(num_arrays);
+  for (auto& arr : src) {
+    std::generate(arr.begin(), arr.end(), [&] { return dist(gen); } );
+  }
+  std::string desc { std::to_string(num_arrays) + " arrays of " + std::to_string(N) + " ints" };
+
+  BENCHMARK_ADVANCED ("std::sort, " + desc)(Catch::Benchmark::Chronometer meter) {
+    std::vector<std::vector<std::array<int, N>>> work(static_cast<std::size_t>(meter.runs()), src); // unsorted each run
+    meter.measure([&work] (int run) {
+      for (auto& arr : work[static_cast<std::size_t>(run)]) { std::sort(arr.begin(), arr.end()); }
+      return work[static_cast<std::size_t>(run)][0][0];
+    } );
+  };
+  BENCHMARK_ADVANCED ("static_sort, " + desc)(Catch::Benchmark::Chronometer meter) {
+    std::vector<std::vector<std::array<int, N>>> work(static_cast<std::size_t>(meter.runs()), src); // unsorted each run
+    meter.measure([&work] (int run) {
+      for (auto& arr : work[static_cast<std::size_t>(run)]) { static_sort(arr); }
+      return work[static_cast<std::size_t>(run)][0][0];
+    } );
+  };
+}
+
+TEST_CASE ("Benchmark sorting networks", "[.][benchmark][static_sort]") {
+  bench_static_sort<4u>();
+  bench_static_sort<8u>();
+  bench_static_sort<16u>();
+}
@@ -23,8 +23,40 @@
 #include <array>
 #include <vector>
 #include <string>
+#include <cstddef> // std::size_t
+#include <utility> // std::index_sequence
+#include <type_traits>
+#include <algorithm> // std::min, std::max
+#include <numeric> // std::accumulate, std::inner_product
+#include <functional> // std::plus
+#include <stdexcept>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <cerrno>
+#include <cstring> // std::memcpy
+#include <bit> // std::endian
+#include <concepts>
+#include <iterator> // std::default_sentinel_t
+#if defined(__linux__)
+#include <pthread.h> // pthread_setaffinity_np
+#endif
+#if __has_include(<sys/mman.h>)
+#define MAPPED_FILE_MMAP
+#include <sys/mman.h> // mmap, madvise
+#include <sys/stat.h> // fstat
+#include <fcntl.h> // open
+#include <unistd.h> // close
+#endif
 
 #include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+
+#include "scoped_trace_catch2.hpp" // TRACE_SCOPE, and the trace file written at the end of a test run
 
 ////////////////////
 // Slide 15 - 17
@@ -35,7 +67,7 @@ constexpr bool is_dyn_ext (std::span<T, SZ> sp) {
   return (SZ == std::dynamic_extent);
 }
 
-constexpr int sum3 (std::span<int, 3> sp) {
+constexpr int sum3 (std::span<const int, 3> sp) {
     return sp[0] + sp[1] + sp[2];
 }
 
@@ -61,6 +93,199 @@ TEST_CASE ("Calling sum3, ensuring 3 contiguous elements", "[sum3]") {
   REQUIRE (sum3(c_arr) == 33);
 }
 
+////////////////////
+// Beyond the slides - reductions over spans
+//
+// sum3 generalized: sum, min, max, dot and fold for a span of any extent. With a
+// static extent the reduction is expanded at compile time into straight line code
+// (a pack expansion, no loop), combining the elements as a balanced tree so the
+// additions are independent of each other and the compiler can pair them up into
+// vector instructions. With std::dynamic_extent it is a loop with four separate
+// accumulators, so each iteration does not wait on the result of the one before.
+//
+// Either way the elements are combined in a different order than a plain left to
+// right loop, which for floating point sums can change the last bits of the result
+// (ints, min and max are unaffected). fold makes no assumption about the operation,
+// so it always combines left to right: fully unrolled for a static extent, a plain
+// loop otherwise.
+////////////////////
+
+namespace span_reduce {
+
+// same test as is_dyn_ext, but on the template parm, so it can be used in an
+// if constexpr (a function parm is never a constant expression)
+template <std::size_t SZ>
+constexpr bool dyn_ext { SZ == std::dynamic_extent };
+
+constexpr std::size_t num_acc { 4u };
+
+// combine(leaf(B), ..., leaf(E - 1)) as a balanced tree, expanded at compile time
+template <std::size_t B, std::size_t E, typename Leaf, typename Combine>
+constexpr auto tree (Leaf leaf, Combine combine) {
+  if constexpr (E - B == 1u) {
+    return leaf(B);
+  }
+  else {
+    constexpr std::size_t M { B + (E - B) / 2u };
+    return combine(tree<B, M>(leaf, combine), tree<M, E>(leaf, combine));
+  }
+}
+
+// four accumulators, each starting from leaf(0) (so only for idempotent combines,
+// or an init that is the identity of combine, as for sum)
+template <typename R, typename Leaf, typename Combine>
+constexpr R multi_acc (std::size_t n, R init, Leaf leaf, Combine combine) {
+  std::array<R, num_acc> acc { init, init, init, init };
+  std::size_t i {0u};
+  for (; (i + num_acc) <= n; i += num_acc) {
+    acc[0] = combine(acc[0], leaf(i));
+    acc[1] = combine(acc[1], leaf(i + 1u));
+    acc[2] = combine(acc[2], leaf(i + 2u));
+    acc[3] = combine(acc[3], leaf(i + 3u));
+  }
+  for (; i < n; ++i) {
+    acc[0] = combine(acc[0], leaf(i));
+  }
+  return combine(combine(acc[0], acc[1]), combine(acc[2], acc[3]));
+}
+
+template <typename T, std::size_t SZ>
+constexpr std::remove_cv_t<T> sum (std::span<T, SZ> sp) {
+  using R = std::remove_cv_t<T>;
+  auto leaf = [sp] (std::size_t i) -> R { return sp[i]; };
+  if constexpr (dyn_ext<SZ>) {
+    return multi_acc(sp.size(), R{}, leaf, std::plus<>{});
+  }
+  else if constexpr (SZ == 0u) {
+    return R{};
+  }
+  else {
+    return tree<0u, SZ>(leaf, std::plus<>{});
+  }
+}
+
+namespace detail {
+
+template <typename T, std::size_t SZ, typename Pick>
+constexpr std::remove_cv_t<T> min_max (std::span<T, SZ> sp, Pick pick) {
+  using R = std::remove_cv_t<T>;
+  auto leaf = [sp] (std::size_t i) -> R { return sp[i]; };
+  if constexpr (dyn_ext<SZ>) {
+    if (sp.empty()) {
+      throw std::range_error("min or max of an empty span");
+    }
+    return multi_acc(sp.size(), sp[0], leaf, pick);
+  }
+  else {
+    static_assert (SZ != 0u, "min or max of an empty span");
+    return tree<0u, SZ>(leaf, pick);
+  }
+}
+
+} // end namespace
+
+template <typename T, std::size_t SZ>
+constexpr std::remove_cv_t<T> min (std::span<T, SZ> sp) {
+  return detail::min_max(sp, [] (const auto& a, const auto& b) { return b < a ? b : a; } );
+}
+
+template <typename T, std::size_t SZ>
+constexpr std::remove_cv_t<T> max (std::span<T, SZ> sp) {
+  return detail::min_max(sp, [] (const auto& a, const auto& b) { return a < b ? b : a; } );
+}
+
+template <typename T, std::size_t SZ1, typename U, std::size_t SZ2>
+constexpr auto dot (std::span<T, SZ1> a, std::span<U, SZ2> b) {
+  using R = std::remove_cvref_t<decltype(a[0] * b[0])>;
+  auto leaf = [a, b] (std::size_t i) -> R { return a[i] * b[i]; };
+  if constexpr (dyn_ext<SZ1> || dyn_ext<SZ2>) {
+    if (a.size() != b.size()) {
+      throw std::range_error("dot of spans with different sizes");
+    }
+    return multi_acc(a.size(), R{}, leaf, std::plus<>{});
+  }
+  else {
+    static_assert (SZ1 == SZ2, "dot of spans with different extents");
+    if constexpr (SZ1 == 0u) {
+      return R{};
+    }
+    else {
+      return tree<0u, SZ1>(leaf, std::plus<>{});
+    }
+  }
+}
+
+// op(...op(op(init, sp[0]), sp[1])..., sp[n - 1])
+template <typename T, std::size_t SZ, typename R, typename Op>
+constexpr R fold (std::span<T, SZ> sp, R init, Op op) {
+  if constexpr (dyn_ext<SZ>) {
+    for (const auto& e : sp) {
+      init = op(init, e);
+    }
+    return init;
+  }
+  else {
+    return [&]<std::size_t... Is> (std::index_sequence<Is...>) {
+      ((init = op(init, sp[Is])), ...);
+      return init;
+    } (std::make_index_sequence<SZ>{});
+  }
+}
+
+} // end namespace
+
+constexpr std::array<int, 3> arr_3 { 10, 11, 12 };
+
+TEST_CASE ("Span reductions, static and dynamic extents", "[span_reduce]") {
+  STATIC_REQUIRE (span_reduce::sum(std::span(arr_3)) == 33); // same as sum3, at compile time
+  STATIC_REQUIRE (span_reduce::min(std::span(arr_3)) == 10);
+  STATIC_REQUIRE (span_reduce::dot(std::span(arr_3), std::span(arr_3)) == 365);
+
+  auto check = [] <typename T, std::size_t SZ> (std::span<T, SZ> a, std::span<T, SZ> b) {
+    std::span<T> dyn_a { a };
+    std::span<T> dyn_b { b };
+    auto expected_sum = std::accumulate(a.begin(), a.end(), T{});
+    auto expected_min = *std::min_element(a.begin(), a.end());
+    auto expected_max = *std::max_element(a.begin(), a.end());
+    auto expected_dot = std::inner_product(a.begin(), a.end(), b.begin(), T{});
+    REQUIRE (span_reduce::sum(a) == expected_sum);
+    REQUIRE (span_reduce::sum(dyn_a) == expected_sum);
+    REQUIRE (span_reduce::min(a) == expected_min);
+    REQUIRE (span_reduce::min(dyn_a) == expected_min);
+    REQUIRE (span_reduce::max(a) == expected_max);
+    REQUIRE (span_reduce::max(dyn_a) == expected_max);
+    REQUIRE (span_reduce::dot(a, b) == expected_dot);
+    REQUIRE (span_reduce::dot(dyn_a, dyn_b) == expected_dot);
+    REQUIRE (span_reduce::dot(a, dyn_b) == expected_dot);
+  };
+
+  std::vector<int> ints;
+  std::vector<float> flts; // small whole numbers, every partial sum is exact
+  for (int i {0}; i < 32; ++i) {
+    ints.push_back((i * 37) % 23 - 11);
+    flts.push_back(static_cast<float>((i * 37) % 23 - 11));
+  }
+  check(std::span<int, 3>(ints.data(), 3u), std::span<int, 3>(ints.data() + 3, 3u));
+  check(std::span<int, 4>(ints.data(), 4u), std::span<int, 4>(ints.data() + 4, 4u));
+  check(std::span<int, 8>(ints.data(), 8u), std::span<int, 8>(ints.data() + 8, 8u));
+  check(std::span<int, 16>(ints.data(), 16u), std::span<int, 16>(ints.data() + 16, 16u));
+  check(std::span<float, 3>(flts.data(), 3u), std::span<float, 3>(flts.data() + 3, 3u));
+  check(std::span<float, 16>(flts.data(), 16u), std::span<float, 16>(flts.data() + 16, 16u));
+  check(std::span<int, 1>(ints.data(), 1u), std::span<int, 1>(ints.data() + 1, 1u));
+
+  std::vector<int> empty;
+  REQUIRE (span_reduce::sum(std::span<int>(empty)) == 0);
+  REQUIRE_THROWS_AS (span_reduce::min(std::span<int>(empty)), std::range_error);
+  REQUIRE_THROWS_AS (span_reduce::dot(std::span<int>(ints), std::span<int>(empty)), std::range_error);
+
+  // fold is left to right, so an operation that is not associative works
+  std::array<int, 4> arr_4 { 1, 2, 3, 4 };
+  REQUIRE (span_reduce::fold(std::span(arr_4), 100, [] (int a, int b) { return a - b; } ) == 90);
+  REQUIRE (span_reduce::fold(std::span<int>(arr_4), 100, [] (int a, int b) { return a - b; } ) == 90);
+  std::array<std::string, 3> strs { "a", "b", "c" };
+  REQUIRE (span_reduce::fold(std::span(strs), std::string{}, std::plus<>{}) == "abc");
+}
+
 ////////////////////
 // Slide 21
 ////////////////////
@@ -85,4 +310,940 @@ TEST_CASE ("Compile time evaluated factorial function", "[factorial]") {
   REQUIRE (factorial<6>() == 720);
 }
 
+////////////////////
+// Beyond the slides - single producer, single consumer ring buffer handing out spans
+//
+// The capacity is a template parm (a power of 2, so wrapping an index is a mask),
+// and the whole storage is a std::span<T, Cap>. Instead of a push and pop per
+// element, the producer asks for a region of free slots, fills it in place, and
+// commits how many it wrote; the consumer does the same with filled slots. A region
+// that crosses the end of the storage is two spans, the second starting at index 0.
+//
+// The head (next slot to write) is only written by the producer and the tail (next
+// slot to read) only by the consumer; each is on its own cache line, along with the
+// other side's index as last seen, so the two threads only share a cache line when
+// one of them has run out of room or data and needs a fresh value.
+////////////////////
+
+constexpr std::size_t cache_line_sz {64u};
+
+template <typename T>
+struct ring_region {
+  std::span<T> first;
+  std::span<T> second; // empty unless the region wraps around
+  std::size_t size () const noexcept { return first.size() + second.size(); }
+  bool empty () const noexcept { return size() == 0u; }
+};
+
+template <typename T, std::size_t Cap>
+class spsc_ring {
+  static_assert (Cap > 0u && (Cap & (Cap - 1u)) == 0u, "capacity must be a power of 2");
+
+  struct alignas(cache_line_sz) side {
+    std::atomic<std::size_t> idx {0u}; // counts up forever, the slot is idx % Cap
+    std::size_t other_seen {0u}; // the other side's idx, as of the last load
+  };
+
+  side m_prod; // idx is the head
+  side m_cons; // idx is the tail
+  alignas(cache_line_sz) std::array<T, Cap> m_buf {};
+
+  ring_region<T> region (std::size_t start, std::size_t n) noexcept {
+    std::size_t pos = start & (Cap - 1u);
+    std::size_t first_n = std::min(n, Cap - pos);
+    return { std::span<T>(m_buf).subspan(pos, first_n), std::span<T>(m_buf).first(n - first_n) };
+  }
+
+public:
+  static constexpr std::size_t capacity () noexcept { return Cap; }
+
+  std::span<T, Cap> storage () noexcept { return m_buf; }
+
+  // producer side: up to max_n free slots, to be filled and then committed
+  ring_region<T> write_region (std::size_t max_n = Cap) noexcept {
+    std::size_t head = m_prod.idx.load(std::memory_order_relaxed);
+    std::size_t free = Cap - (head - m_prod.other_seen);
+    if (free < max_n) { // refresh, the consumer may have read more
+      m_prod.other_seen = m_cons.idx.load(std::memory_order_acquire);
+      free = Cap - (head - m_prod.other_seen);
+    }
+    return region(head, std::min(free, max_n));
+  }
+  void commit_write (std::size_t n) noexcept {
+    m_prod.idx.store(m_prod.idx.load(std::memory_order_relaxed) + n, std::memory_order_release);
+  }
+
+  // consumer side: up to max_n filled slots, to be used and then committed
+  ring_region<T> read_region (std::size_t max_n = Cap) noexcept {
+    std::size_t tail = m_cons.idx.load(std::memory_order_relaxed);
+    std::size_t avail = m_cons.other_seen - tail;
+    if (avail < max_n) { // refresh, the producer may have written more
+      m_cons.other_seen = m_prod.idx.load(std::memory_order_acquire);
+      avail = m_cons.other_seen - tail;
+    }
+    return region(tail, std::min(avail, max_n));
+  }
+  void commit_read (std::size_t n) noexcept {
+    m_cons.idx.store(m_cons.idx.load(std::memory_order_relaxed) + n, std::memory_order_release);
+  }
+
+  // approximate when called while the other side is running
+  std::size_t size () const noexcept {
+    return m_prod.idx.load(std::memory_order_acquire) - m_cons.idx.load(std::memory_order_acquire);
+  }
+};
+
+// Pins the calling thread to one CPU (Linux only) for its lifetime and puts the
+// previous affinity back on destruction. Does nothing when the CPU does not exist,
+// and the thread then runs wherever the scheduler puts it.
+class cpu_pin {
+#if defined(__linux__)
+  cpu_set_t m_prev;
+  bool m_pinned { false };
+#endif
+public:
+  explicit cpu_pin ([[maybe_unused]] unsigned int cpu) {
+#if defined(__linux__)
+    if (cpu < std::thread::hardware_concurrency() &&
+        pthread_getaffinity_np(pthread_self(), sizeof(m_prev), &m_prev) == 0) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(cpu, &set);
+      m_pinned = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+#endif
+  }
+  ~cpu_pin () {
+#if defined(__linux__)
+    if (m_pinned) {
+      pthread_setaffinity_np(pthread_self(), sizeof(m_prev), &m_prev);
+    }
+#endif
+  }
+  cpu_pin (const cpu_pin&) = delete;
+  cpu_pin& operator= (const cpu_pin&) = delete;
+  bool pinned () const noexcept {
+#if defined(__linux__)
+    return m_pinned;
+#else
+    return false;
+#endif
+  }
+};
+
+// spin briefly, then give up the time slice (needed when both threads share a CPU)
+inline void spin_wait (unsigned int& spins) {
+  if (++spins > 64u) {
+    std::this_thread::yield();
+    spins = 0u;
+  }
+}
+
+TEST_CASE ("SPSC ring buffer regions", "[spsc_ring]") {
+  spsc_ring<int, 8> ring;
+  STATIC_REQUIRE (decltype(ring)::capacity() == 8u);
+  STATIC_REQUIRE (std::is_same_v<decltype(ring.storage()), std::span<int, 8>>);
+
+  auto w = ring.write_region(5u);
+  REQUIRE (w.size() == 5u);
+  REQUIRE (w.second.empty());
+  std::iota(w.first.begin(), w.first.end(), 0); // 0 .. 4
+  ring.commit_write(5u);
+  REQUIRE (ring.size() == 5u);
+
+  auto r = ring.read_region(3u);
+  REQUIRE (r.size() == 3u);
+  REQUIRE (r.first[2] == 2);
+  ring.commit_read(3u);
+
+  w = ring.write_region(); // slots 5, 6, 7, then 0, 1, 2
+  REQUIRE (w.size() == 6u);
+  REQUIRE (w.first.size() == 3u);
+  REQUIRE (w.second.size() == 3u);
+  REQUIRE (w.second.data() == ring.storage().data());
+  std::iota(w.first.begin(), w.first.end(), 5);
+  std::iota(w.second.begin(), w.second.end(), 8);
+  ring.commit_write(6u);
+  REQUIRE (ring.write_region().empty()); // full
+
+  r = ring.read_region();
+  REQUIRE (r.size() == 8u);
+  std::vector<int> vals (r.first.begin(), r.first.end());
+  vals.insert(vals.end(), r.second.begin(), r.second.end());
+  REQUIRE (vals == std::vector<int>{ 3, 4, 5, 6, 7, 8, 9, 10 });
+  ring.commit_read(8u);
+  REQUIRE (ring.read_region().empty());
+}
+
+TEST_CASE ("SPSC ring buffer, two threads", "[spsc_ring]") {
+  constexpr std::uint32_t num_vals { 200'000u };
+  spsc_ring<std::uint32_t, 1024> ring;
+
+  std::thread producer ([&ring] {
+    std::uint32_t next {0u};
+    unsigned int spins {0u};
+    while (next < num_vals) {
+      auto w = ring.write_region(std::min<std::size_t>(1u + next % 97u, num_vals - next)); // varying batches
+      if (w.empty()) {
+        spin_wait(spins);
+        continue;
+      }
+      for (auto sp : { w.first, w.second }) {
+        for (auto& v : sp) {
+          v = next++;
+        }
+      }
+      ring.commit_write(w.size());
+    }
+  } );
+
+  std::uint32_t expected {0u};
+  bool in_order { true };
+  unsigned int spins {0u};
+  while (expected < num_vals) {
+    auto r = ring.read_region(1u + expected % 61u);
+    if (r.empty()) {
+      spin_wait(spins);
+      continue;
+    }
+    for (auto sp : { r.first, r.second }) {
+      for (auto v : sp) {
+        in_order = in_order && (v == expected++);
+      }
+    }
+    ring.commit_read(r.size());
+  }
+  producer.join();
+  REQUIRE (in_order);
+  REQUIRE (ring.size() == 0u);
+}
+
+
+
+////////////////////
+// Beyond the slides - a memory mapped file as a span
+//
+// A file mapped into the address space is a contiguous range of bytes like any
+// other, so it can be handed to anything taking a span, with nothing read into a
+// buffer first; pages are brought in by the OS as they are touched. mapped_file owns
+// the mapping (unmapped in the destructor), bytes() is the whole file, and as<T>()
+// views it as Ts, checking the alignment and that the size is a whole number of Ts.
+//
+// Where there is no mmap (e.g. Windows, which has its own file mapping API) the
+// file is read into memory instead, with the same interface.
+////////////////////
+
+class mapped_file {
+public:
+  enum class access { normal, sequential, random }; // passed on as an madvise hint
+
+  explicit mapped_file (const std::filesystem::path& path, access hint = access::sequential) {
+    TRACE_SCOPE("mapped_file");
+#if defined(MAPPED_FILE_MMAP)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::system_error(errno, std::generic_category(), "mapped_file open " + path.string());
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      int err = errno;
+      ::close(fd);
+      throw std::system_error(err, std::generic_category(), "mapped_file fstat " + path.string());
+    }
+    m_size = static_cast<std::size_t>(st.st_size);
+    if (m_size > 0u) { // mmap of 0 bytes fails, an empty file is an empty span
+      void* p = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+        int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "mapped_file mmap " + path.string());
+      }
+      m_data = static_cast<const std::byte*>(p);
+      ::madvise(p, m_size, hint == access::sequential ? MADV_SEQUENTIAL :
+                           hint == access::random ? MADV_RANDOM : MADV_NORMAL); // only a hint
+    }
+    ::close(fd); // the mapping keeps the file open
+#else
+    static_cast<void>(hint);
+    std::ifstream ifs (path, std::ios::binary);
+    if (!ifs) {
+      throw std::system_error(std::make_error_code(std::errc::no_such_file_or_directory),
+                              "mapped_file open " + path.string());
+    }
+    m_buf.resize(static_cast<std::size_t>(std::filesystem::file_size(path)));
+    ifs.read(reinterpret_cast<char*>(m_buf.data()), static_cast<std::streamsize>(m_buf.size()));
+    m_data = m_buf.data();
+    m_size = m_buf.size();
+#endif
+  }
+
+  ~mapped_file () { unmap(); }
+
+  mapped_file (mapped_file&& rhs) noexcept { swap(rhs); }
+  mapped_file& operator= (mapped_file&& rhs) noexcept {
+    mapped_file tmp { std::move(rhs) };
+    swap(tmp);
+    return *this;
+  }
+  mapped_file (const mapped_file&) = delete;
+  mapped_file& operator= (const mapped_file&) = delete;
+
+  std::size_t size () const noexcept { return m_size; }
+
+  std::span<const std::byte> bytes () const noexcept { return { m_data, m_size }; }
+
+  // the bytes from offset to the end as Ts; throws if they are not aligned for T or
+  // are not a whole number of Ts
+  template <typename T>
+  std::span<const T> as (std::size_t offset = 0u) const {
+    static_assert (std::is_trivially_copyable_v<T>, "mapped bytes can only be viewed as trivially copyable types");
+    if (offset > m_size) {
+      throw std::range_error("mapped_file offset is past the end of the file");
+    }
+    const std::byte* p { m_data + offset };
+    if (reinterpret_cast<std::uintptr_t>(p) % alignof(T) != 0u) {
+      throw std::range_error("mapped_file data is not aligned for the requested type");
+    }
+    if ((m_size - offset) % sizeof(T) != 0u) {
+      throw std::range_error("mapped_file size is not a multiple of the requested type size");
+    }
+    return { reinterpret_cast<const T*>(p), (m_size - offset) / sizeof(T) };
+  }
+
+private:
+  void swap (mapped_file& rhs) noexcept {
+    std::swap(m_data, rhs.m_data);
+    std::swap(m_size, rhs.m_size);
+#if !defined(MAPPED_FILE_MMAP)
+    m_buf.swap(rhs.m_buf);
+#endif
+  }
+  void unmap () noexcept {
+#if defined(MAPPED_FILE_MMAP)
+    if (m_data != nullptr) {
+      ::munmap(const_cast<std::byte*>(m_data), m_size);
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0u;
+  }
+
+  const std::byte* m_data { nullptr };
+  std::size_t m_size {0u};
+#if !defined(MAPPED_FILE_MMAP)
+  std::vector<std::byte> m_buf;
+#endif
+};
+
+// writes the span to a file in the temp directory, removing it on destruction
+class temp_file {
+public:
+  template <typename T>
+  temp_file (const std::string& name, std::span<const T> data) :
+      m_path { std::filesystem::temp_directory_path() / name } {
+    std::ofstream ofs (m_path, std::ios::binary | std::ios::trunc);
+    ofs.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size_bytes()));
+    if (!ofs) {
+      throw std::runtime_error("unable to write temp file " + m_path.string());
+    }
+  }
+  ~temp_file () {
+    std::error_code ec;
+    std::filesystem::remove(m_path, ec);
+  }
+  temp_file (const temp_file&) = delete;
+  temp_file& operator= (const temp_file&) = delete;
+  const std::filesystem::path& path () const noexcept { return m_path; }
+private:
+  std::filesystem::path m_path;
+};
+
+// the read into a vector approach, for comparison
+template <typename T>
+std::vector<T> read_into_vec (const std::filesystem::path& path) {
+  TRACE_SCOPE("read_into_vec");
+  std::ifstream ifs (path, std::ios::binary);
+  std::vector<T> v (static_cast<std::size_t>(std::filesystem::file_size(path)) / sizeof(T));
+  ifs.read(reinterpret_cast<char*>(v.data()), static_cast<std::streamsize>(v.size() * sizeof(T)));
+  return v;
+}
+
+TEST_CASE ("Memory mapped file as a span", "[mapped_file]") {
+  std::vector<int> vals (1'000u);
+  std::iota(vals.begin(), vals.end(), 0);
+  temp_file tf ("std_span_test_mapped_file.bin", std::span<const int>(vals));
+
+  mapped_file mf (tf.path());
+  REQUIRE (mf.size() == vals.size() * sizeof(int));
+  REQUIRE (mf.bytes().size() == mf.size());
+
+  auto ints = mf.as<int>();
+  REQUIRE (ints.size() == vals.size());
+  REQUIRE (std::equal(ints.begin(), ints.end(), vals.begin()));
+  REQUIRE (sum3(ints.first<3>()) == 3); // 0 + 1 + 2, straight from the file
+  REQUIRE (sum3(ints.subspan<10, 3>()) == 33);
+  REQUIRE (span_reduce::sum(ints) == 499'500);
+  REQUIRE (span_reduce::max(ints) == 999);
+
+  REQUIRE (mf.as<int>(sizeof(int) * 4u).front() == 4);
+  REQUIRE_THROWS_AS (mf.as<int>(1u), std::range_error); // misaligned
+  REQUIRE_THROWS_AS (mf.as<double>(sizeof(int)), std::range_error); // misaligned, or odd size
+  REQUIRE_THROWS_AS (mf.as<int>(mf.size() + 1u), std::range_error);
+  REQUIRE (mf.as<int>(mf.size()).empty());
+
+  mapped_file moved { std::move(mf) };
+  REQUIRE (moved.as<int>().back() == 999);
+  REQUIRE (mf.bytes().empty());
+
+  REQUIRE_THROWS_AS (mapped_file(tf.path().string() + ".does_not_exist"), std::system_error);
+
+  temp_file empty ("std_span_test_mapped_file_empty.bin", std::span<const int>{});
+  REQUIRE (mapped_file(empty.path()).bytes().empty());
+}
+
+////////////////////
+// Beyond the slides - framed messages, chunks and endian field readers
+//
+// Parsing length prefixed messages out of a buffer (or a mapped_file) without
+// copying them: frame_view walks the bytes and yields, for each frame, the header
+// as a static extent span (its size is part of the message format, so a compile
+// time constant) and the payload as a dynamic extent span, both pointing into the
+// buffer. chunks<N> is the same idea for fixed size records, yielding each record
+// as a span<T, N>.
+//
+// The field readers take a static extent span, so the offset and size of a field
+// are checked at compile time and the read is a single load (plus a byte swap, a
+// single bswap or movbe instruction, when the endianness differs from the CPU's).
+////////////////////
+
+namespace frames {
+
+// std::byteswap is C++23; each byte is moved to its mirrored position, expanded at
+// compile time (a loop is not always unrolled), which compilers turn into a bswap
+template <std::unsigned_integral T>
+constexpr T byteswap (T v) noexcept {
+  return [v] <std::size_t... Is> (std::index_sequence<Is...>) {
+    return static_cast<T>(((((v >> (Is * 8u)) & T{0xffu}) << ((sizeof(T) - 1u - Is) * 8u)) | ...));
+  } (std::make_index_sequence<sizeof(T)>{});
+}
+
+// a T stored with the given endianness; the span is exactly sizeof(T) bytes
+template <std::integral T, std::endian E = std::endian::big>
+T load (std::span<const std::byte, sizeof(T)> sp) noexcept {
+  std::make_unsigned_t<T> v;
+  std::memcpy(&v, sp.data(), sizeof(T));
+  if constexpr (E != std::endian::native) {
+    v = byteswap(v);
+  }
+  return static_cast<T>(v);
+}
+
+// a T at byte offset Off of a fixed size header
+template <std::integral T, std::size_t Off, std::endian E = std::endian::big, std::size_t N>
+T field (std::span<const std::byte, N> hdr) noexcept {
+  static_assert (N != std::dynamic_extent, "fields are read from a static extent span");
+  static_assert (Off + sizeof(T) <= N, "field extends past the end of the header");
+  return load<T, E>(hdr.template subspan<Off, sizeof(T)>());
+}
+
+// consecutive N element chunks of a span, as static extent spans; a partial chunk
+// at the end is not visited, it is tail()
+template <typename T, std::size_t N>
+class chunk_view {
+  static_assert (N > 0u && N != std::dynamic_extent);
+public:
+  class iterator {
+  public:
+    using value_type = std::span<T, N>;
+    using difference_type = std::ptrdiff_t;
+    iterator () = default;
+    explicit iterator (T* p) noexcept : m_p(p) { }
+    std::span<T, N> operator* () const noexcept { return std::span<T, N>(m_p, N); }
+    iterator& operator++ () noexcept { m_p += N; return *this; }
+    iterator operator++ (int) noexcept { iterator tmp { *this }; m_p += N; return tmp; }
+    bool operator== (const iterator&) const = default;
+  private:
+    T* m_p { nullptr };
+  };
+
+  explicit chunk_view (std::span<T> sp) noexcept : m_sp(sp) { }
+
+  std::size_t size () const noexcept { return m_sp.size() / N; }
+  iterator begin () const noexcept { return iterator(m_sp.data()); }
+  iterator end () const noexcept { return iterator(m_sp.data() + size() * N); }
+  std::span<T> tail () const noexcept { return m_sp.subspan(size() * N); }
+
+private:
+  std::span<T> m_sp;
+};
+
+template <std::size_t N, typename T, std::size_t SZ>
+chunk_view<T, N> chunks (std::span<T, SZ> sp) noexcept {
+  return chunk_view<T, N>(sp);
+}
+
+template <std::size_t HdrSz>
+struct frame {
+  std::span<const std::byte, HdrSz> header;
+  std::span<const std::byte> payload;
+};
+
+// frames of a HdrSz byte header followed by a payload whose size len_fn reads from
+// the header; iteration stops at the end of the buffer or at a frame that is not
+// complete, which is left in rest() (e.g. to be completed from the next read)
+template <std::size_t HdrSz, typename LenFn>
+class frame_view {
+public:
+  class iterator {
+  public:
+    using value_type = frame<HdrSz>;
+    using difference_type = std::ptrdiff_t;
+    iterator () = default;
+    iterator (std::span<const std::byte> buf, const LenFn* len_fn) noexcept :
+        m_rest(buf), m_len_fn(len_fn) { next_frame(); }
+
+    frame<HdrSz> operator* () const noexcept {
+      return { m_rest.template first<HdrSz>(), m_rest.subspan(HdrSz, m_payload_sz) };
+    }
+    iterator& operator++ () noexcept {
+      m_rest = m_rest.subspan(HdrSz + m_payload_sz);
+      next_frame();
+      return *this;
+    }
+    iterator operator++ (int) noexcept { iterator tmp { *this }; ++*this; return tmp; }
+    bool operator== (std::default_sentinel_t) const noexcept { return m_done; }
+
+    // the bytes from the current frame on
+    std::span<const std::byte> rest () const noexcept { return m_rest; }
+
+  private:
+    void next_frame () noexcept {
+      if (m_rest.size() < HdrSz) {
+        m_done = true;
+        return;
+      }
+      m_payload_sz = (*m_len_fn)(m_rest.template first<HdrSz>());
+      m_done = m_payload_sz > m_rest.size() - HdrSz;
+    }
+
+    std::span<const std::byte> m_rest;
+    const LenFn* m_len_fn { nullptr };
+    std::size_t m_payload_sz {0u};
+    bool m_done { true };
+  };
+
+  frame_view (std::span<const std::byte> buf, LenFn len_fn) : m_buf(buf), m_len_fn(std::move(len_fn)) { }
+
+  iterator begin () const noexcept { return iterator(m_buf, &m_len_fn); }
+  std::default_sentinel_t end () const noexcept { return { }; }
+
+  // calls func for each complete frame, returns the bytes left over
+  template <typename F>
+  std::span<const std::byte> for_each (F func) const {
+    iterator it { begin() };
+    for (; it != end(); ++it) {
+      func(*it);
+    }
+    return it.rest();
+  }
+
+private:
+  std::span<const std::byte> m_buf;
+  LenFn m_len_fn;
+};
+
+template <std::size_t HdrSz, typename LenFn>
+frame_view<HdrSz, LenFn> frames_of (std::span<const std::byte> buf, LenFn len_fn) {
+  return frame_view<HdrSz, LenFn>(buf, std::move(len_fn));
+}
+
+} // end namespace frames
+
+// an example message format: an 8 byte big endian header of a 16 bit type, 16 bit
+// flags and a 32 bit payload size, then the payload
+namespace msg_fmt {
+
+constexpr std::size_t hdr_sz {8u};
+
+using header = std::span<const std::byte, hdr_sz>;
 
+inline std::uint16_t type (header h) noexcept { return frames::field<std::uint16_t, 0u>(h); }
+inline std::uint16_t flags (header h) noexcept { return frames::field<std::uint16_t, 2u>(h); }
+inline std::uint32_t payload_sz (header h) noexcept { return frames::field<std::uint32_t, 4u>(h); }
+
+inline auto frames_of (std::span<const std::byte> buf) {
+  return frames::frames_of<hdr_sz>(buf, [] (header h) { return std::size_t { payload_sz(h) }; });
+}
+
+inline void append_be (std::vector<std::byte>& buf, std::uint64_t val, std::size_t n) {
+  for (std::size_t i {n}; i > 0u; --i) {
+    buf.push_back(static_cast<std::byte>((val >> ((i - 1u) * 8u)) & 0xffu));
+  }
+}
+
+inline void append_frame (std::vector<std::byte>& buf, std::uint16_t typ, std::uint16_t flgs,
+                          std::span<const std::byte> payload) {
+  append_be(buf, typ, 2u);
+  append_be(buf, flgs, 2u);
+  append_be(buf, payload.size(), 4u);
+  buf.insert(buf.end(), payload.begin(), payload.end());
+}
+
+// n frames with payloads of 0 to 63 bytes
+inline std::vector<std::byte> gen_frames (std::size_t n) {
+  std::vector<std::byte> buf;
+  std::array<std::byte, 64> payload;
+  for (std::size_t i {0u}; i < payload.size(); ++i) {
+    payload[i] = static_cast<std::byte>(i);
+  }
+  for (std::size_t i {0u}; i < n; ++i) {
+    append_frame(buf, static_cast<std::uint16_t>(i % 7u), static_cast<std::uint16_t>(i & 0x3u),
+                 std::span<const std::byte>(payload).first((i * 13u) % 64u));
+  }
+  return buf;
+}
+
+} // end namespace msg_fmt
+
+TEST_CASE ("Endian field readers", "[frames]") {
+  STATIC_REQUIRE (frames::byteswap(std::uint32_t{0x01020304u}) == 0x04030201u);
+  STATIC_REQUIRE (frames::byteswap(std::uint16_t{0xabcdu}) == 0xcdabu);
+  STATIC_REQUIRE (frames::byteswap(std::uint8_t{0x7fu}) == 0x7fu);
+
+  std::array<std::byte, 8> bytes { std::byte{0x01}, std::byte{0x02}, std::byte{0x03}, std::byte{0x04},
+                                   std::byte{0xff}, std::byte{0xfe}, std::byte{0x00}, std::byte{0x80} };
+  std::span<const std::byte, 8> sp (bytes);
+  REQUIRE (frames::field<std::uint16_t, 0u>(sp) == 0x0102u);
+  REQUIRE (frames::field<std::uint16_t, 0u, std::endian::little>(sp) == 0x0201u);
+  REQUIRE (frames::field<std::uint32_t, 0u>(sp) == 0x01020304u);
+  REQUIRE (frames::field<std::uint32_t, 4u, std::endian::little>(sp) == 0x8000feffu);
+  REQUIRE (frames::field<std::int16_t, 4u>(sp) == -2);
+  REQUIRE (frames::field<std::uint64_t, 0u>(sp) == 0x01020304fffe0080u);
+  REQUIRE (frames::field<std::uint8_t, 7u>(sp) == 0x80u);
+}
+
+TEST_CASE ("Chunked span view", "[frames]") {
+  std::array<int, 10> arr { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  auto cv = frames::chunks<3>(std::span<const int>(arr));
+  REQUIRE (cv.size() == 3u);
+  std::vector<int> sums;
+  for (std::span<const int, 3> chunk : cv) {
+    sums.push_back(sum3(chunk));
+  }
+  REQUIRE (sums == std::vector<int>{ 3, 12, 21 });
+  REQUIRE (cv.tail().size() == 1u);
+  REQUIRE (cv.tail()[0] == 9);
+
+  auto exact = frames::chunks<5>(std::span<int, 10>(arr));
+  REQUIRE (exact.size() == 2u);
+  REQUIRE (exact.tail().empty());
+  for (auto chunk : exact) {
+    chunk[0] = -1; // chunks of a non-const span are writable
+  }
+  REQUIRE (arr[5] == -1);
+  REQUIRE (frames::chunks<11>(std::span<int>(arr)).begin() == frames::chunks<11>(std::span<int>(arr)).end());
+}
+
+TEST_CASE ("Framed message view", "[frames]") {
+  std::vector<std::byte> buf;
+  std::array<std::byte, 3> payload { std::byte{'a'}, std::byte{'b'}, std::byte{'c'} };
+  msg_fmt::append_frame(buf, 1u, 0x10u, payload);
+  msg_fmt::append_frame(buf, 2u, 0x20u, {});
+  msg_fmt::append_frame(buf, 3u, 0x30u, std::span<const std::byte>(payload).first(2u));
+  const std::size_t complete_sz { buf.size() };
+
+  std::vector<std::uint16_t> types;
+  std::size_t total_payload {0u};
+  for (auto [hdr, pl] : msg_fmt::frames_of(buf)) {
+    types.push_back(msg_fmt::type(hdr));
+    REQUIRE (msg_fmt::flags(hdr) == msg_fmt::type(hdr) * 0x10u);
+    REQUIRE (pl.size() == msg_fmt::payload_sz(hdr));
+    total_payload += pl.size();
+  }
+  REQUIRE (types == std::vector<std::uint16_t>{ 1u, 2u, 3u });
+  REQUIRE (total_payload == 5u);
+
+  auto first = *msg_fmt::frames_of(buf).begin();
+  REQUIRE (first.payload.data() == buf.data() + msg_fmt::hdr_sz); // no copy
+  REQUIRE (first.payload[2] == std::byte{'c'});
+
+  // a frame cut short is left over, as is a partial header
+  msg_fmt::append_frame(buf, 4u, 0x40u, payload);
+  std::span<const std::byte> all (buf);
+  int cnt {0};
+  auto rest = msg_fmt::frames_of(all.first(buf.size() - 1u)).for_each([&cnt] (auto) { ++cnt; } );
+  REQUIRE (cnt == 3);
+  REQUIRE (rest.size() == buf.size() - 1u - complete_sz);
+  cnt = 0;
+  rest = msg_fmt::frames_of(all.first(complete_sz + 5u)).for_each([&cnt] (auto) { ++cnt; } );
+  REQUIRE (cnt == 3);
+  REQUIRE (rest.size() == 5u);
+  REQUIRE (msg_fmt::frames_of(all.first(0u)).for_each([] (auto) { }).empty());
+}
+
+////////////////////
+// Beyond the slides - benchmarks
+//
+// The benchmark test cases are hidden (the "[.]" tag), so they do not run as part
+// of the unit tests; run them with e.g. std_span_test "[benchmark]"
+////////////////////
+
+// n small vectors of SZ floats each, one after another
+template <std::size_t SZ>
+std::vector<float> gen_small_vecs (std::size_t n) {
+  std::vector<float> v(n * SZ);
+  for (std::size_t i {0u}; i < v.size(); ++i) {
+    v[i] = static_cast<float>(i % 101u) * 0.25f;
+  }
+  return v;
+}
+
+template <std::size_t SZ>
+void bench_small_vecs (std::size_t n) {
+  auto a = gen_small_vecs<SZ>(n);
+  auto b = gen_small_vecs<SZ>(n);
+  std::string desc { std::to_string(SZ) + " floats, " + std::to_string(n / 1'000'000u) + "M vectors" };
+  // the size of each vector as a run time value, as it is for a dynamic extent span
+  // whose size comes from the data (a literal SZ would let the compiler unroll anyway)
+  const std::size_t dyn_sz { a.size() / n };
+
+  BENCHMARK ("loop over dynamic span, sum of " + desc) {
+    float total {0.0f};
+    for (std::size_t i {0u}; i < n; ++i) {
+      std::span<const float> sp (a.data() + i * dyn_sz, dyn_sz);
+      total += std::accumulate(sp.begin(), sp.end(), 0.0f);
+    }
+    return total;
+  };
+  BENCHMARK ("span_reduce::sum static extent, sum of " + desc) {
+    float total {0.0f};
+    for (std::size_t i {0u}; i < n; ++i) {
+      total += span_reduce::sum(std::span<const float, SZ>(a.data() + i * SZ, SZ));
+    }
+    return total;
+  };
+  BENCHMARK ("loop over dynamic span, dot of " + desc) {
+    float total {0.0f};
+    for (std::size_t i {0u}; i < n; ++i) {
+      std::span<const float> sa (a.data() + i * dyn_sz, dyn_sz);
+      total += std::inner_product(sa.begin(), sa.end(), b.data() + i * dyn_sz, 0.0f);
+    }
+    return total;
+  };
+  BENCHMARK ("span_reduce::dot static extent, dot of " + desc) {
+    float total {0.0f};
+    for (std::size_t i {0u}; i < n; ++i) {
+      total += span_reduce::dot(std::span<const float, SZ>(a.data() + i * SZ, SZ),
+                                std::span<const float, SZ>(b.data() + i * SZ, SZ));
+    }
+    return total;
+  };
+  BENCHMARK ("loop over dynamic span, max of " + desc) {
+    float total {0.0f};
+    for (std::size_t i {0u}; i < n; ++i) {
+      std::span<const float> sp (a.data() + i * dyn_sz, dyn_sz);
+      total += *std::max_element(sp.begin(), sp.end());
+    }
+    return total;
+  };
+  BENCHMARK ("span_reduce::max static extent, max of " + desc) {
+    float total {0.0f};
+    for (std::size_t i {0u}; i < n; ++i) {
+      total += span_reduce::max(std::span<const float, SZ>(a.data() + i * SZ, SZ));
+    }
+    return total;
+  };
+}
+
+TEST_CASE ("Benchmark span reductions, small static extents", "[.][benchmark][span_reduce]") {
+  bench_small_vecs<3u>(1'000'000u);
+  bench_small_vecs<4u>(1'000'000u);
+  bench_small_vecs<8u>(1'000'000u);
+  bench_small_vecs<16u>(1'000'000u);
+}
+
+TEST_CASE ("Benchmark span reductions, dynamic extent", "[.][benchmark][span_reduce]") {
+  auto a = gen_small_vecs<1u>(1'000'000u);
+  std::span<const float> sp { a };
+
+  BENCHMARK ("std::accumulate, 1M floats") {
+    return std::accumulate(sp.begin(), sp.end(), 0.0f);
+  };
+  BENCHMARK ("span_reduce::sum, four accumulators, 1M floats") {
+    return span_reduce::sum(sp);
+  };
+  BENCHMARK ("std::max_element, 1M floats") {
+    return *std::max_element(sp.begin(), sp.end());
+  };
+  BENCHMARK ("span_reduce::max, four accumulators, 1M floats") {
+    return span_reduce::max(sp);
+  };
+}
+
+TEST_CASE ("Benchmark SPSC ring buffer", "[.][benchmark][spsc_ring]") {
+  constexpr std::uint64_t num_vals { 10'000'000u };
+
+  // the producer writes num_vals values in batches of up to batch_sz, the consumer
+  // sums them; run on two CPUs when there are two to pin to
+  auto throughput = [] (std::size_t batch_sz) {
+    spsc_ring<std::uint64_t, 4096> ring;
+    std::thread producer ([&ring, batch_sz] {
+      cpu_pin pin {1u};
+      std::uint64_t next {0u};
+      unsigned int spins {0u};
+      while (next < num_vals) {
+        auto w = ring.write_region(batch_sz);
+        if (w.empty()) {
+          spin_wait(spins);
+          continue;
+        }
+        for (auto sp : { w.first, w.second }) {
+          for (auto& v : sp) {
+            v = next++;
+          }
+        }
+        ring.commit_write(w.size());
+      }
+    } );
+    cpu_pin pin {0u};
+    std::uint64_t sum {0u};
+    std::uint64_t cnt {0u};
+    unsigned int spins {0u};
+    while (cnt < num_vals) {
+      auto r = ring.read_region(batch_sz);
+      if (r.empty()) {
+        spin_wait(spins);
+        continue;
+      }
+      for (auto sp : { r.first, r.second }) {
+        for (auto v : sp) {
+          sum += v;
+        }
+      }
+      cnt += r.size();
+      ring.commit_read(r.size());
+    }
+    producer.join();
+    return sum;
+  };
+
+  BENCHMARK ("spsc_ring throughput, 10M values, batches of 1") {
+    return throughput(1u);
+  };
+  BENCHMARK ("spsc_ring throughput, 10M values, batches of 64") {
+    return throughput(64u);
+  };
+  BENCHMARK ("spsc_ring throughput, 10M values, batches of 1024") {
+    return throughput(1'024u);
+  };
+
+  // one value sent back and forth through two rings; the mean is the round trip time
+  BENCHMARK_ADVANCED ("spsc_ring round trip latency, 10K round trips")(Catch::Benchmark::Chronometer meter) {
+    constexpr int num_trips { 10'000 };
+    spsc_ring<int, 64> ping;
+    spsc_ring<int, 64> pong;
+    std::atomic<bool> done { false };
+    std::thread echo ([&] {
+      cpu_pin pin {1u};
+      unsigned int spins {0u};
+      while (!done.load(std::memory_order_relaxed)) {
+        auto r = ping.read_region(1u);
+        if (r.empty()) {
+          spin_wait(spins);
+          continue;
+        }
+        auto w = pong.write_region(1u);
+        w.first[0] = r.first[0];
+        ping.commit_read(1u);
+        pong.commit_write(1u);
+      }
+    } );
+    cpu_pin pin {0u};
+    meter.measure([&] {
+      unsigned int spins {0u};
+      for (int i {0}; i < num_trips; ++i) {
+        auto w = ping.write_region(1u);
+        w.first[0] = i;
+        ping.commit_write(1u);
+        ring_region<int> r;
+        while ((r = pong.read_region(1u)).empty()) {
+          spin_wait(spins);
+        }
+        pong.commit_read(1u);
+      }
+      return num_trips;
+    } );
+    done.store(true);
+    echo.join();
+  };
+}
+
+TEST_CASE ("Benchmark memory mapped file", "[.][benchmark][mapped_file]") {
+  // a 64 MB file of unsigned ints, summed; the file is in the page cache after it is
+  // written, so this compares the copy into a vector with mapping the cached pages
+  std::vector<std::uint32_t> vals (16u * 1'024u * 1'024u);
+  std::iota(vals.begin(), vals.end(), 0u);
+  temp_file tf ("std_span_test_mapped_file_bench.bin", std::span<const std::uint32_t>(vals));
+  vals = std::vector<std::uint32_t>{};
+
+  BENCHMARK ("read into vector, then sum, 64 MB") {
+    auto v = read_into_vec<std::uint32_t>(tf.path());
+    return span_reduce::sum(std::span<const std::uint32_t>(v));
+  };
+  BENCHMARK ("mapped_file, sum, 64 MB") {
+    mapped_file mf (tf.path());
+    return span_reduce::sum(mf.as<std::uint32_t>());
+  };
+  BENCHMARK ("mapped_file random hint, sum, 64 MB") {
+    mapped_file mf (tf.path(), mapped_file::access::random);
+    return span_reduce::sum(mf.as<std::uint32_t>());
+  };
+}
+
+TEST_CASE ("Benchmark framed message parsing", "[.][benchmark][frames]") {
+  constexpr std::size_t num_frames { 2'000'000u };
+  auto buf = msg_fmt::gen_frames(num_frames);
+
+  // the copying approach: decode each header into a struct and copy the payload
+  // into a (reused) vector
+  struct message {
+    std::uint16_t type;
+    std::uint16_t flags;
+    std::uint32_t payload_sz;
+    std::vector<std::byte> payload;
+  };
+
+  BENCHMARK ("copy into struct, 2M frames") {
+    message msg;
+    std::uint64_t total {0u};
+    std::size_t pos {0u};
+    while (pos + msg_fmt::hdr_sz <= buf.size()) {
+      auto be = [&buf] (std::size_t p, std::size_t n) {
+        std::uint32_t v {0u};
+        for (std::size_t i {0u}; i < n; ++i) {
+          v = (v << 8) | std::to_integer<std::uint32_t>(buf[p + i]);
+        }
+        return v;
+      };
+      msg.type = static_cast<std::uint16_t>(be(pos, 2u));
+      msg.flags = static_cast<std::uint16_t>(be(pos + 2u, 2u));
+      msg.payload_sz = be(pos + 4u, 4u);
+      pos += msg_fmt::hdr_sz;
+      if (pos + msg.payload_sz > buf.size()) {
+        break;
+      }
+      msg.payload.assign(buf.begin() + static_cast<std::ptrdiff_t>(pos),
+                         buf.begin() + static_cast<std::ptrdiff_t>(pos + msg.payload_sz));
+      pos += msg.payload_sz;
+      total += msg.type + msg.flags + msg.payload.size();
+    }
+    return total;
+  };
+  BENCHMARK ("frame_view, 2M frames") {
+    std::uint64_t total {0u};
+    for (auto [hdr, pl] : msg_fmt::frames_of(buf)) {
+      total += msg_fmt::type(hdr) + msg_fmt::flags(hdr) + pl.size();
+    }
+    return total;
+  };
+}
@@ -23,9 +23,34 @@
 #include <array>
 #include <stdexcept>
 #include <algorithm>
+#include <span>
+#include <compare>
+#include <cstring> // std::memcmp, std::memcpy
+#include <functional> // std::hash
+#include <type_traits> // std::is_constant_evaluated
+#include <vector>
+#include <unordered_set>
+#include <unordered_map>
+#include <utility> // std::exchange
+#include <bit> // std::countr_zero
+#include <memory> // std::construct_at, std::allocator, std::uninitialized_copy_n
+#include <new> // std::launder
+#include <cstddef> // std::byte
+#include <initializer_list>
+#include <atomic>
+#include <limits>
+#include <sstream>
+#include <thread>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/catch_template_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+
+#include "scoped_trace_catch2.hpp" // TRACE_SCOPE, and the trace file written at the end of a test run
+#include "batch_kernels.hpp" // isa:: level dispatch, batch::square, add_div_by_3, add_sub_div
 
 ////////////////////
 // Slide 6
@@ -44,6 +69,283 @@ TEST_CASE( "Factorials are computed", "[factorial]" ) {
   REQUIRE( factorial(0) == 1 ); // now works with corrected logic above
 }
 
+////////////////////
+// Beyond the slides - factorial, binomial and permutation tables
+//
+// The factorial above recurses at run time and silently wraps past 12! in 32 bits.
+// Here the values are computed once, at compile time, into tables as large as the
+// result type allows: 21 factorials in 64 bits, 35 in 128 bits (GCC and Clang have
+// unsigned __int128, MSVC does not). A run time lookup is then one array index, and
+// asking for a value that does not fit throws std::range_error, which in a constant
+// expression is a compile error. The template argument versions check with a
+// static_assert instead.
+//
+// Binomial coefficients are a flat Pascal's triangle, with as many rows as fit in
+// the type (68 rows in 64 bits), and permutations P(n, k) = n! / (n - k)! a
+// triangle with the same rows as the factorial table. Past the tables, big_uint
+// is a minimal arbitrary precision unsigned integer that computes the exact value.
+////////////////////
+
+namespace comb {
+
+#if defined(__SIZEOF_INT128__)
+using uint128 = unsigned __int128;
+#endif
+
+// numeric_limits is not specialized for unsigned __int128 in strict ISO mode
+template <typename U>
+constexpr U max_of { static_cast<U>(~U{0u}) };
+
+// largest n where n! fits in U
+template <typename U>
+consteval std::size_t max_factorial_n () {
+  U f {1u};
+  std::size_t n {0u};
+  while (f <= max_of<U> / static_cast<U>(n + 1u)) {
+    ++n;
+    f *= static_cast<U>(n);
+  }
+  return n;
+}
+
+// largest n where every C(n, k) fits in U; the largest of a row is the middle
+template <typename U>
+consteval std::size_t max_binomial_n () {
+  std::array<U, 256> row {};
+  row[0] = 1u;
+  for (std::size_t n {1u}; n < row.size(); ++n) {
+    for (std::size_t k {n}; k > 0u; --k) {
+      if (row[k] > max_of<U> - row[k - 1u]) {
+        return n - 1u;
+      }
+      row[k] += row[k - 1u];
+    }
+  }
+  return row.size() - 1u;
+}
+
+constexpr std::size_t tri_idx (std::size_t n, std::size_t k) { return n * (n + 1u) / 2u + k; }
+
+template <typename U>
+constexpr auto factorial_table = [] {
+  std::array<U, max_factorial_n<U>() + 1u> t {};
+  t[0] = 1u;
+  for (std::size_t i {1u}; i < t.size(); ++i) {
+    t[i] = t[i - 1u] * static_cast<U>(i);
+  }
+  return t;
+} ();
+
+template <typename U>
+constexpr auto binomial_table = [] {
+  constexpr std::size_t rows { max_binomial_n<U>() + 1u };
+  std::array<U, tri_idx(rows, 0u)> t {};
+  for (std::size_t n {0u}; n < rows; ++n) {
+    t[tri_idx(n, 0u)] = 1u;
+    t[tri_idx(n, n)] = 1u;
+    for (std::size_t k {1u}; k < n; ++k) {
+      t[tri_idx(n, k)] = t[tri_idx(n - 1u, k - 1u)] + t[tri_idx(n - 1u, k)];
+    }
+  }
+  return t;
+} ();
+
+template <typename U>
+constexpr auto permutation_table = [] {
+  constexpr std::size_t rows { max_factorial_n<U>() + 1u };
+  std::array<U, tri_idx(rows, 0u)> t {};
+  for (std::size_t n {0u}; n < rows; ++n) {
+    t[tri_idx(n, 0u)] = 1u;
+    for (std::size_t k {1u}; k <= n; ++k) { // P(n, k) = P(n, k - 1) * (n - k + 1)
+      t[tri_idx(n, k)] = t[tri_idx(n, k - 1u)] * static_cast<U>(n - k + 1u);
+    }
+  }
+  return t;
+} ();
+
+template <typename U = std::uint64_t>
+constexpr U factorial (std::size_t n) {
+  if (n >= factorial_table<U>.size()) {
+    throw std::range_error("factorial does not fit in the result type");
+  }
+  return factorial_table<U>[n];
+}
+
+// C(n, k), 0 when k > n
+template <typename U = std::uint64_t>
+constexpr U binomial (std::size_t n, std::size_t k) {
+  if (n > max_binomial_n<U>()) {
+    throw std::range_error("binomial coefficient table does not have this row");
+  }
+  return k > n ? U{0u} : binomial_table<U>[tri_idx(n, k)];
+}
+
+// P(n, k), the number of ordered selections of k out of n, 0 when k > n
+template <typename U = std::uint64_t>
+constexpr U permutations (std::size_t n, std::size_t k) {
+  if (n > max_factorial_n<U>()) {
+    throw std::range_error("permutation table does not have this row");
+  }
+  return k > n ? U{0u} : permutation_table<U>[tri_idx(n, k)];
+}
+
+template <std::size_t N, typename U = std::uint64_t>
+consteval U factorial () {
+  static_assert (N <= max_factorial_n<U>(), "N! does not fit in the result type");
+  return factorial_table<U>[N];
+}
+
+template <std::size_t N, std::size_t K, typename U = std::uint64_t>
+consteval U binomial () {
+  static_assert (N <= max_binomial_n<U>(), "C(N, K) table does not have this row");
+  return binomial<U>(N, K);
+}
+
+// Little endian base 2^32 limbs, no leading zero limbs (zero has none). Only what
+// the factorial and binomial fallbacks need: multiply and divide by a 32 bit value.
+class big_uint {
+  std::vector<std::uint32_t> m_limbs;
+public:
+  big_uint (std::uint64_t v = 0u) {
+    for (; v != 0u; v >>= 32u) {
+      m_limbs.push_back(static_cast<std::uint32_t>(v));
+    }
+  }
+
+  bool is_zero () const noexcept { return m_limbs.empty(); }
+
+  big_uint& operator*= (std::uint32_t m) {
+    std::uint64_t carry {0u};
+    for (auto& l : m_limbs) {
+      std::uint64_t t = static_cast<std::uint64_t>(l) * m + carry;
+      l = static_cast<std::uint32_t>(t);
+      carry = t >> 32u;
+    }
+    if (carry != 0u) {
+      m_limbs.push_back(static_cast<std::uint32_t>(carry));
+    }
+    if (m == 0u) {
+      m_limbs.clear();
+    }
+    return *this;
+  }
+
+  // divides in place, returns the remainder
+  std::uint32_t div_rem (std::uint32_t d) {
+    if (d == 0u) {
+      throw std::range_error("big_uint division by zero");
+    }
+    std::uint64_t rem {0u};
+    for (auto it = m_limbs.rbegin(); it != m_limbs.rend(); ++it) {
+      std::uint64_t cur = (rem << 32u) | *it;
+      *it = static_cast<std::uint32_t>(cur / d);
+      rem = cur % d;
+    }
+    while (!m_limbs.empty() && m_limbs.back() == 0u) {
+      m_limbs.pop_back();
+    }
+    return static_cast<std::uint32_t>(rem);
+  }
+
+  std::string to_string () const {
+    if (is_zero()) {
+      return "0";
+    }
+    big_uint tmp { *this };
+    std::vector<std::uint32_t> chunks; // base 10^9, least significant first
+    while (!tmp.is_zero()) {
+      chunks.push_back(tmp.div_rem(1'000'000'000u));
+    }
+    std::string str = std::to_string(chunks.back());
+    for (auto it = chunks.rbegin() + 1; it != chunks.rend(); ++it) {
+      auto digits = std::to_string(*it);
+      str.append(9u - digits.size(), '0');
+      str += digits;
+    }
+    return str;
+  }
+
+  friend bool operator== (const big_uint&, const big_uint&) = default;
+};
+
+inline big_uint big_factorial (std::uint32_t n) {
+  big_uint f {1u};
+  for (std::uint32_t i {2u}; i <= n; ++i) {
+    f *= i;
+  }
+  return f;
+}
+
+// C(n, k) = prod (n - k + i) / i, for i in 1..k; every partial result is C(n - k + i, i)
+inline big_uint big_binomial (std::uint32_t n, std::uint32_t k) {
+  if (k > n) {
+    return big_uint{0u};
+  }
+  k = std::min(k, n - k);
+  big_uint c {1u};
+  for (std::uint32_t i {1u}; i <= k; ++i) {
+    c *= (n - k + i);
+    c.div_rem(i);
+  }
+  return c;
+}
+
+} // end namespace
+
+#if defined(__SIZEOF_INT128__)
+std::string u128_to_string (comb::uint128 v) {
+  std::string str;
+  do {
+    str.insert(str.begin(), static_cast<char>('0' + static_cast<int>(v % 10u)));
+    v /= 10u;
+  } while (v != 0u);
+  return str;
+}
+#endif
+
+TEST_CASE( "Factorial, binomial, permutation tables", "[factorial][comb]" ) {
+  STATIC_REQUIRE( comb::factorial_table<std::uint32_t>.size() == 13u ); // 12! is the last in 32 bits
+  STATIC_REQUIRE( comb::factorial_table<std::uint64_t>.size() == 21u );
+  STATIC_REQUIRE( comb::factorial<20>() == 2'432'902'008'176'640'000u );
+  STATIC_REQUIRE( comb::binomial<67, 33>() == 14'226'520'737'620'288'370u );
+  STATIC_REQUIRE( comb::max_binomial_n<std::uint64_t>() == 67u );
+  // comb::factorial<21>() and comb::binomial<68, 34>() do not compile
+
+  REQUIRE( comb::factorial(10) == 3'628'800u );
+  REQUIRE( comb::factorial<std::uint32_t>(12) == factorial(12) );
+  REQUIRE_THROWS_AS( comb::factorial(21), std::range_error );
+  REQUIRE_THROWS_AS( comb::factorial<std::uint32_t>(13), std::range_error );
+  REQUIRE( comb::binomial(5, 2) == 10u );
+  REQUIRE( comb::binomial(5, 6) == 0u );
+  REQUIRE_THROWS_AS( comb::binomial(68, 1), std::range_error );
+  REQUIRE( comb::permutations(5, 2) == 20u );
+  REQUIRE( comb::permutations(20, 20) == comb::factorial(20) );
+  REQUIRE( comb::permutations(5, 6) == 0u );
+
+  REQUIRE( comb::big_factorial(20) == comb::big_uint{comb::factorial(20)} );
+  REQUIRE( comb::big_factorial(50).to_string() ==
+           "30414093201713378043612608166064768844377641568960512000000000000" );
+  REQUIRE( comb::big_binomial(67, 33) == comb::big_uint{comb::binomial(67, 33)} );
+  REQUIRE( comb::big_binomial(100, 50).to_string() == "100891344545564193334812497256" );
+  REQUIRE( comb::big_uint{}.to_string() == "0" );
+
+  bool all_equal {true};
+  for (std::uint32_t n {0u}; n <= 67u; ++n) {
+    for (std::uint32_t k {0u}; k <= n; ++k) {
+      all_equal = all_equal && (comb::big_binomial(n, k) == comb::big_uint{comb::binomial(n, k)});
+    }
+  }
+  REQUIRE( all_equal );
+
+#if defined(__SIZEOF_INT128__)
+  STATIC_REQUIRE( comb::factorial_table<comb::uint128>.size() == 35u );
+  STATIC_REQUIRE( comb::max_binomial_n<comb::uint128>() == 131u );
+  REQUIRE( u128_to_string(comb::factorial<comb::uint128>(34)) == comb::big_factorial(34).to_string() );
+  REQUIRE( u128_to_string(comb::binomial<comb::uint128>(131, 65)) == comb::big_binomial(131, 65).to_string() );
+  REQUIRE( u128_to_string(comb::permutations<comb::uint128>(34, 10)) == "475837794432000" );
+#endif
+}
+
 ////////////////////
 // Slide 15
 ////////////////////
@@ -74,6 +376,71 @@ TEMPLATE_TEST_CASE( "Square generic", "[square-generic][square]",
   REQUIRE( square<TestType>(3) == std::pow(3, 2));
 }
 
+////////////////////
+// Beyond the slides - batch square, add_div_by_3, add_sub_div with run time ISA dispatch
+//
+// The batch kernels and the ISA level selection are in examples/common/batch_kernels.hpp,
+// shared with the span versions of add_div_by_3 and add_sub_div in the
+// intro_generic_programming examples. Every ISA level the CPU supports is tested
+// here against the scalar code.
+////////////////////
+
+// small enough that nothing overflows, and a - b is never 0
+template <typename T>
+std::vector<T> gen_batch_vals (std::size_t n, std::size_t mult, int offset) {
+  std::vector<T> v;
+  for (std::size_t i {0}; i < n; ++i) {
+    v.push_back(static_cast<T>(static_cast<int>(i * mult % 2'001u) - 1'000 + offset));
+  }
+  return v;
+}
+
+TEMPLATE_TEST_CASE( "Square generic, batch, every ISA level", "[square-generic][square][batch]",
+                     int, short, float, double ) {
+  auto a = gen_batch_vals<TestType>(1'003u, 37u, 0); // not a multiple of any vector width
+  auto b = gen_batch_vals<TestType>(1'003u, 37u, 2'002);
+  std::vector<TestType> out(a.size());
+
+  for (std::size_t l {0}; l <= static_cast<std::size_t>(isa::detected()); ++l) {
+    isa::force_guard guard { static_cast<isa::level>(l) };
+    INFO( "ISA level " << isa::name(isa::active()) );
+    REQUIRE( isa::active() == static_cast<isa::level>(l) );
+
+    batch::square<TestType>(a, out);
+    bool all_equal {true};
+    for (std::size_t i {0}; i < a.size(); ++i) {
+      all_equal = all_equal && (out[i] == static_cast<TestType>(square(a[i])));
+    }
+    REQUIRE( all_equal );
+
+    batch::add_div_by_3<TestType>(a, b, out);
+    for (std::size_t i {0}; i < a.size(); ++i) {
+      all_equal = all_equal && (out[i] == static_cast<TestType>((a[i] + b[i]) / TestType(3)));
+    }
+    REQUIRE( all_equal );
+
+    batch::add_sub_div<TestType>(a, b, out);
+    for (std::size_t i {0}; i < a.size(); ++i) {
+      all_equal = all_equal && (out[i] == static_cast<TestType>((a[i] + b[i]) / (a[i] - b[i])));
+    }
+    REQUIRE( all_equal );
+  }
+  REQUIRE( isa::active() == isa::detected() );
+  REQUIRE_THROWS_AS( batch::square<TestType>(a, std::span<TestType>(out).first(1)), std::range_error );
+}
+
+TEST_CASE( "ISA level can only be forced down", "[batch]" ) {
+  if (isa::detected() < isa::level::avx512) {
+    auto above = static_cast<isa::level>(static_cast<int>(isa::detected()) + 1);
+    REQUIRE_THROWS_AS( isa::force(above), std::range_error );
+    REQUIRE( isa::active() == isa::detected() );
+  }
+  isa::force(isa::level::base);
+  REQUIRE( isa::active() == isa::level::base );
+  isa::clear_force();
+  REQUIRE( isa::active() == isa::detected() );
+}
+
 ////////////////////
 // Slides 18 - 29
 ////////////////////
@@ -81,39 +448,115 @@ TEMPLATE_TEST_CASE( "Square generic", "[square-generic][square]",
 // this is the final, corrected code - see the presentation for
 // the initial buggy code
 
+// Beyond the slides - get_str builds a new std::string on every call, so view and
+// span accessors are provided that do not allocate, along with comparison and
+// hashing (the hash is the same as for a std::string_view with the same chars,
+// which allows heterogeneous lookup). Everything except get_str is constexpr.
+//
+// The chars past the current size are always zero (the array is value initialized
+// and the size never shrinks), so equality compares the whole fixed size array.
+// For the common small sizes the compiler turns that into a few wide loads and
+// compares (e.g. one or two SSE compares for 16 or 32 chars) instead of a byte loop.
+// The copy in the ctor and append is a std::copy of chars, which is a memmove.
+//
+// The ctor and append logic does not depend on max_sz other than as a value, so
+// at run time it is done by non-template functions that work on (chars, size,
+// capacity). Every f_str size calls the one out of line copy of that code, instead
+// of each size inlining its own (the functions are marked noinline, since the
+// compiler would otherwise inline them back into every caller in this file).
+// Constant evaluation cannot call them, so the ctor and append use the constexpr
+// versions, which hold the same logic, when is_constant_evaluated.
+
+namespace f_str_core {
+
+constexpr void assign_ce (char* chars, std::size_t& curr_size, std::size_t cap, std::string_view s) {
+  if (s.length() > cap) { throw std::range_error("str too big"); }
+  if (cap != 0u) { std::copy(s.begin(), s.end(), chars); } // chars is null for f_str<0>
+  curr_size = s.length();
+}
+
+constexpr void append_ce (char* chars, std::size_t& curr_size, std::size_t cap, std::string_view s) {
+  if ((curr_size + s.length()) > cap) {
+    throw std::range_error("appended len too big");
+  }
+  if (cap != 0u) { std::copy(s.begin(), s.end(), chars + curr_size); }
+  curr_size += s.length();
+}
+
+#if defined(__GNUC__)
+[[gnu::noinline]]
+#endif
+void assign (char* chars, std::size_t& curr_size, std::size_t cap, std::string_view s) {
+  assign_ce(chars, curr_size, cap, s);
+}
+
+#if defined(__GNUC__)
+[[gnu::noinline]]
+#endif
+void append (char* chars, std::size_t& curr_size, std::size_t cap, std::string_view s) {
+  append_ce(chars, curr_size, cap, s);
+}
+
+} // end namespace
+
 template <std::size_t max_sz>
 class f_str {
 public:
-  f_str() = default;
-  f_str(std::string_view);
-  void append(std::string_view);
-  std::string get_str() const noexcept {
+  constexpr f_str() = default;
+  constexpr f_str(std::string_view);
+  constexpr void append(std::string_view);
+  std::string get_str() const {
     return std::string(m_chars.data(), m_curr_size);
   }
-  std::size_t size() const noexcept { return m_curr_size; }
-  std::size_t max_size() const noexcept { return max_sz; }
+  constexpr std::string_view view() const noexcept {
+    return std::string_view(m_chars.data(), m_curr_size);
+  }
+  constexpr std::span<const char> span() const noexcept {
+    return std::span<const char>(m_chars.data(), m_curr_size);
+  }
+  constexpr std::size_t size() const noexcept { return m_curr_size; }
+  constexpr std::size_t max_size() const noexcept { return max_sz; }
+
+  friend constexpr bool operator== (const f_str& lhs, const f_str& rhs) noexcept {
+    if (lhs.m_curr_size != rhs.m_curr_size) { return false; }
+    if constexpr (max_sz == 0u) { return true; } // no chars, and data() may be null
+    if (std::is_constant_evaluated()) { return lhs.m_chars == rhs.m_chars; }
+    return std::memcmp(lhs.m_chars.data(), rhs.m_chars.data(), max_sz) == 0; // fixed size compare
+  }
+  friend constexpr std::strong_ordering operator<=> (const f_str& lhs, const f_str& rhs) noexcept {
+    return lhs.view() <=> rhs.view();
+  }
 private:
-  std::array<char, max_sz> m_chars;
+  std::array<char, max_sz> m_chars {};
   std::size_t m_curr_size {0};
 };
 
 
 template <std::size_t max_sz>
-f_str<max_sz>::f_str(std::string_view s) : m_chars{}, m_curr_size{0} {
-  if (s.length() > max_sz) { throw std::range_error("str too big"); }
-  std::copy(s.begin(), s.end(), m_chars.begin());
-  m_curr_size = s.length();
+constexpr f_str<max_sz>::f_str(std::string_view s) : m_chars{}, m_curr_size{0} {
+  if (std::is_constant_evaluated()) {
+    f_str_core::assign_ce(m_chars.data(), m_curr_size, max_sz, s);
+    return;
+  }
+  f_str_core::assign(m_chars.data(), m_curr_size, max_sz, s);
 }
 
 template <std::size_t max_sz>
-void f_str<max_sz>::append (std::string_view s) {
-  if ((m_curr_size + s.length()) > max_sz) {
-    throw std::range_error("appended len too big");
+constexpr void f_str<max_sz>::append (std::string_view s) {
+  if (std::is_constant_evaluated()) {
+    f_str_core::append_ce(m_chars.data(), m_curr_size, max_sz, s);
+    return;
   }
-  std::copy(s.begin(), s.end(), (m_chars.begin() + m_curr_size));
-  m_curr_size += s.length();
+  f_str_core::append(m_chars.data(), m_curr_size, max_sz, s);
 }
 
+template <std::size_t max_sz>
+struct std::hash<f_str<max_sz>> {
+  std::size_t operator() (const f_str<max_sz>& f) const noexcept {
+    return std::hash<std::string_view>{}(f.view());
+  }
+};
+
 //
 // Testing functions
 //
@@ -188,3 +631,882 @@ TEST_CASE( "f_str throw", "[f_str]" ) {
   throw_test_append<2>("a", "ab");
 }
 
+TEST_CASE( "f_str view, compare, hash", "[f_str]" ) {
+  STATIC_REQUIRE( f_str<10>("Howdy!").view() == "Howdy!" );
+  STATIC_REQUIRE( f_str<10>("abc") == f_str<10>("abc") );
+  STATIC_REQUIRE( f_str<10>("abc") < f_str<10>("abd") );
+  STATIC_REQUIRE( [] { f_str<10> f("Howdy"); f.append("!"); return f; }() == f_str<10>("Howdy!") );
+
+  f_str<16> a("Balloon");
+  f_str<16> b("Balloon");
+  REQUIRE( a == b );
+  b.append(" Fiesta");
+  REQUIRE( a != b );
+  REQUIRE( a < b ); // prefix orders first
+  a.append(" Fiesta");
+  REQUIRE( a == b );
+  REQUIRE( (a <=> b) == std::strong_ordering::equal );
+  REQUIRE( f_str<16>("") < f_str<16>("a") );
+  REQUIRE( f_str<16>("\xff") > f_str<16>("a") ); // chars compare as unsigned, same as std::string
+
+  REQUIRE( a.span().size() == a.size() );
+  REQUIRE( a.view() == a.get_str() );
+  REQUIRE( std::hash<f_str<16>>{}(a) == std::hash<std::string_view>{}("Balloon Fiesta") );
+
+  std::unordered_set<f_str<32>> keys { f_str<32>("alpha"), f_str<32>("beta") };
+  REQUIRE( keys.contains(f_str<32>("beta")) );
+  REQUIRE( !keys.contains(f_str<32>("gamma")) );
+}
+
+////////////////////
+// Beyond the slides - flat hash map with f_str keys
+//
+// An open addressing hash map in the style of the "Swiss table" - keys (and values)
+// are stored inline in one slot array, so a lookup does not allocate or chase a
+// node pointer. A separate array holds one control byte per slot: empty, deleted,
+// or the low 7 bits of the key's hash. Slots are probed a group of 16 at a time,
+// comparing all 16 control bytes at once (one SSE2 compare on x86-64, a loop the
+// compiler vectorizes elsewhere), and the key itself is only compared for control
+// bytes that match.
+////////////////////
+
+namespace flat_ctrl {
+
+constexpr std::int8_t empty { -128 };
+constexpr std::int8_t deleted { -2 };
+constexpr std::size_t group_sz { 16u };
+
+// bit i of the result is set when byte i of the group equals b
+inline std::uint32_t match (const std::int8_t* grp, std::int8_t b) noexcept {
+#if defined(__SSE2__) || defined(_M_X64)
+  auto ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(grp));
+  return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(b))));
+#else
+  std::uint32_t mask {0u};
+  for (std::size_t i {0u}; i < group_sz; ++i) {
+    mask |= static_cast<std::uint32_t>(grp[i] == b) << i;
+  }
+  return mask;
+#endif
+}
+
+} // end namespace
+
+template <std::size_t max_sz, typename V>
+class f_str_map {
+public:
+  using key_type = f_str<max_sz>;
+
+  f_str_map() : m_ctrl(flat_ctrl::group_sz, flat_ctrl::empty), m_slots(flat_ctrl::group_sz) { }
+
+  std::size_t size() const noexcept { return m_size; }
+  bool empty() const noexcept { return m_size == 0u; }
+
+  V* find (const key_type& key) noexcept {
+    auto idx = find_index(key, std::hash<key_type>{}(key));
+    return idx == npos ? nullptr : &m_slots[idx].value;
+  }
+  const V* find (const key_type& key) const noexcept {
+    auto idx = find_index(key, std::hash<key_type>{}(key));
+    return idx == npos ? nullptr : &m_slots[idx].value;
+  }
+  bool contains (const key_type& key) const noexcept { return find(key) != nullptr; }
+
+  // returns false (and leaves the value alone) if the key is already present
+  bool insert (const key_type& key, V val) {
+    auto h = std::hash<key_type>{}(key);
+    if (find_index(key, h) != npos) { return false; }
+    if ((m_size + m_deleted + 1u) * 8u > m_slots.size() * 7u) { // max load factor 7/8
+      rehash(m_size * 2u + 1u > m_slots.size() * 7u / 8u ? m_slots.size() * 2u : m_slots.size());
+    }
+    place(key, std::move(val), h);
+    return true;
+  }
+
+  bool erase (const key_type& key) noexcept {
+    auto idx = find_index(key, std::hash<key_type>{}(key));
+    if (idx == npos) { return false; }
+    m_ctrl[idx] = flat_ctrl::deleted; // tombstone, so that probing continues past it
+    --m_size;
+    ++m_deleted;
+    return true;
+  }
+
+private:
+  struct slot {
+    key_type key;
+    V value;
+  };
+  static constexpr std::size_t npos { static_cast<std::size_t>(-1) };
+
+  static std::int8_t h2 (std::size_t h) noexcept { return static_cast<std::int8_t>(h & 0x7Fu); }
+  std::size_t num_groups () const noexcept { return m_slots.size() / flat_ctrl::group_sz; }
+
+  std::size_t find_index (const key_type& key, std::size_t h) const noexcept {
+    auto grp_mask = num_groups() - 1u;
+    auto grp = (h >> 7u) & grp_mask;
+    for (std::size_t step {1u}; ; ++step) { // triangular probing visits every group
+      const auto* ctrl = m_ctrl.data() + grp * flat_ctrl::group_sz;
+      for (auto m = flat_ctrl::match(ctrl, h2(h)); m != 0u; m &= m - 1u) {
+        auto idx = grp * flat_ctrl::group_sz + static_cast<std::size_t>(std::countr_zero(m));
+        if (m_slots[idx].key == key) { return idx; }
+      }
+      if (flat_ctrl::match(ctrl, flat_ctrl::empty) != 0u || step > num_groups()) { return npos; }
+      grp = (grp + step) & grp_mask;
+    }
+  }
+
+  void place (const key_type& key, V val, std::size_t h) {
+    auto grp_mask = num_groups() - 1u;
+    auto grp = (h >> 7u) & grp_mask;
+    for (std::size_t step {1u}; ; ++step) {
+      const auto* ctrl = m_ctrl.data() + grp * flat_ctrl::group_sz;
+      auto free_slots = flat_ctrl::match(ctrl, flat_ctrl::empty) | flat_ctrl::match(ctrl, flat_ctrl::deleted);
+      if (free_slots != 0u) {
+        auto idx = grp * flat_ctrl::group_sz + static_cast<std::size_t>(std::countr_zero(free_slots));
+        if (m_ctrl[idx] == flat_ctrl::deleted) { --m_deleted; }
+        m_ctrl[idx] = h2(h);
+        m_slots[idx] = slot { key, std::move(val) };
+        ++m_size;
+        return;
+      }
+      grp = (grp + step) & grp_mask;
+    }
+  }
+
+  void rehash (std::size_t new_cap) {
+    auto old_ctrl = std::exchange(m_ctrl, std::vector<std::int8_t>(new_cap, flat_ctrl::empty));
+    auto old_slots = std::exchange(m_slots, std::vector<slot>(new_cap));
+    m_size = 0u;
+    m_deleted = 0u;
+    for (std::size_t i {0u}; i < old_slots.size(); ++i) {
+      if (old_ctrl[i] >= 0) {
+        place(old_slots[i].key, std::move(old_slots[i].value), std::hash<key_type>{}(old_slots[i].key));
+      }
+    }
+  }
+
+  std::vector<std::int8_t> m_ctrl;
+  std::vector<slot> m_slots; // size is a power of 2, and a multiple of the group size
+  std::size_t m_size {0u};
+  std::size_t m_deleted {0u};
+};
+
+TEST_CASE( "f_str_map insert, find, erase", "[f_str_map]" ) {
+  f_str_map<16, int> m;
+  REQUIRE( m.empty() );
+  REQUIRE( m.insert(f_str<16>("Howdy"), 1) );
+  REQUIRE( m.insert(f_str<16>("Podnah"), 2) );
+  REQUIRE( !m.insert(f_str<16>("Howdy"), 3) ); // already present
+  REQUIRE( m.size() == 2u );
+  REQUIRE( *m.find(f_str<16>("Howdy")) == 1 );
+  REQUIRE( m.find(f_str<16>("Howd")) == nullptr );
+  REQUIRE( m.erase(f_str<16>("Howdy")) );
+  REQUIRE( !m.erase(f_str<16>("Howdy")) );
+  REQUIRE( !m.contains(f_str<16>("Howdy")) );
+  REQUIRE( m.contains(f_str<16>("Podnah")) );
+  REQUIRE( m.insert(f_str<16>(""), 4) ); // empty key is a key like any other
+  REQUIRE( *m.find(f_str<16>("")) == 4 );
+}
+
+TEST_CASE( "f_str_map growth and tombstones, against std::unordered_map", "[f_str_map]" ) {
+  f_str_map<16, std::size_t> m;
+  std::unordered_map<std::string, std::size_t> ref;
+  for (std::size_t i {0}; i < 5'000u; ++i) {
+    auto k = std::to_string(i * 7919u % 3'001u);
+    REQUIRE( m.insert(f_str<16>(k), i) == ref.emplace(k, i).second );
+    if (i % 3u == 0u) {
+      auto e = std::to_string(i % 1'499u);
+      REQUIRE( m.erase(f_str<16>(e)) == (ref.erase(e) == 1u) );
+    }
+  }
+  REQUIRE( m.size() == ref.size() );
+  for (std::size_t i {0}; i < 3'001u; ++i) {
+    auto k = std::to_string(i);
+    auto it = ref.find(k);
+    auto* v = m.find(f_str<16>(k));
+    REQUIRE( (v == nullptr) == (it == ref.end()) );
+    if (v != nullptr) { REQUIRE( *v == it->second ); }
+  }
+}
+
+////////////////////
+// Beyond the slides - fixed_vector and small_vector
+//
+// The f_str design (inline storage, a size counter, std::range_error on overflow)
+// generalized to any element type. fixed_vector<T, N> never allocates; small_vector<T, N>
+// keeps up to N elements inline and moves them to the heap when it grows past that.
+// Storage is raw bytes, so elements are only constructed when they are added and are
+// destroyed when removed. When T is trivially copyable, copies, moves, inserts and
+// erases are a memcpy or memmove.
+//
+// As with f_str_core, the element shuffling that does not depend on N is in one set
+// of functions that work on (data, size), shared by both containers and all sizes.
+////////////////////
+
+namespace vec_core {
+
+template <typename T>
+void copy_construct_n (const T* src, std::size_t n, T* dst) {
+  if constexpr (std::is_trivially_copyable_v<T>) {
+    if (n != 0u) { std::memcpy(dst, src, n * sizeof(T)); }
+  }
+  else {
+    std::uninitialized_copy_n(src, n, dst);
+  }
+}
+
+// move n elements into uninitialized storage, destroying the originals
+template <typename T>
+void relocate_n (T* src, std::size_t n, T* dst) {
+  if constexpr (std::is_trivially_copyable_v<T>) {
+    if (n != 0u) { std::memcpy(dst, src, n * sizeof(T)); }
+  }
+  else {
+    std::uninitialized_move_n(src, n, dst);
+    std::destroy_n(src, n);
+  }
+}
+
+// there must be room for one more element
+template <typename T>
+void insert_at (T* data, std::size_t& sz, std::size_t idx, T&& val) {
+  if constexpr (std::is_trivially_copyable_v<T>) {
+    std::memmove(data + idx + 1u, data + idx, (sz - idx) * sizeof(T));
+    std::construct_at(data + idx, std::move(val));
+  }
+  else if (idx == sz) {
+    std::construct_at(data + sz, std::move(val));
+  }
+  else {
+    std::construct_at(data + sz, std::move(data[sz - 1u]));
+    std::move_backward(data + idx, data + sz - 1u, data + sz);
+    data[idx] = std::move(val);
+  }
+  ++sz;
+}
+
+template <typename T>
+void erase_at (T* data, std::size_t& sz, std::size_t idx) {
+  if constexpr (std::is_trivially_copyable_v<T>) {
+    std::memmove(data + idx, data + idx + 1u, (sz - idx - 1u) * sizeof(T));
+  }
+  else {
+    std::move(data + idx + 1u, data + sz, data + idx);
+    std::destroy_at(data + sz - 1u);
+  }
+  --sz;
+}
+
+} // end namespace
+
+template <typename T, std::size_t N>
+class fixed_vector {
+public:
+  using value_type = T;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  fixed_vector() = default;
+  fixed_vector(std::initializer_list<T> il) { append(std::span<const T>(il.begin(), il.size())); }
+  fixed_vector(const fixed_vector& other) { append(other.span()); }
+  fixed_vector(fixed_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    vec_core::relocate_n(other.data(), other.m_size, data());
+    m_size = std::exchange(other.m_size, 0u);
+  }
+  fixed_vector& operator= (const fixed_vector& other) {
+    if (this != &other) {
+      clear();
+      append(other.span());
+    }
+    return *this;
+  }
+  fixed_vector& operator= (fixed_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    if (this != &other) {
+      clear();
+      vec_core::relocate_n(other.data(), other.m_size, data());
+      m_size = std::exchange(other.m_size, 0u);
+    }
+    return *this;
+  }
+  ~fixed_vector() { clear(); }
+
+  template <typename... Args>
+  T& emplace_back (Args&&... args) {
+    if (m_size == N) { throw std::range_error("fixed_vector full"); }
+    auto* p = std::construct_at(data() + m_size, std::forward<Args>(args)...);
+    ++m_size;
+    return *p;
+  }
+  void push_back (const T& val) { emplace_back(val); }
+  void push_back (T&& val) { emplace_back(std::move(val)); }
+  void append (std::span<const T> vals) {
+    if ((m_size + vals.size()) > N) { throw std::range_error("appended len too big"); }
+    vec_core::copy_construct_n(vals.data(), vals.size(), data() + m_size);
+    m_size += vals.size();
+  }
+  iterator insert (const_iterator pos, T val) {
+    if (m_size == N) { throw std::range_error("fixed_vector full"); }
+    auto idx = static_cast<std::size_t>(pos - data());
+    vec_core::insert_at(data(), m_size, idx, std::move(val));
+    return data() + idx;
+  }
+  iterator erase (const_iterator pos) {
+    auto idx = static_cast<std::size_t>(pos - data());
+    vec_core::erase_at(data(), m_size, idx);
+    return data() + idx;
+  }
+  void pop_back () { std::destroy_at(data() + m_size - 1u); --m_size; }
+  void clear () noexcept { std::destroy_n(data(), m_size); m_size = 0u; }
+
+  T* data () noexcept { return std::launder(reinterpret_cast<T*>(m_buf.data())); }
+  const T* data () const noexcept { return std::launder(reinterpret_cast<const T*>(m_buf.data())); }
+  std::span<const T> span () const noexcept { return std::span<const T>(data(), m_size); }
+  T& operator[] (std::size_t i) noexcept { return data()[i]; }
+  const T& operator[] (std::size_t i) const noexcept { return data()[i]; }
+  iterator begin () noexcept { return data(); }
+  iterator end () noexcept { return data() + m_size; }
+  const_iterator begin () const noexcept { return data(); }
+  const_iterator end () const noexcept { return data() + m_size; }
+  std::size_t size () const noexcept { return m_size; }
+  bool empty () const noexcept { return m_size == 0u; }
+  static constexpr std::size_t capacity () noexcept { return N; }
+
+  friend bool operator== (const fixed_vector& lhs, const fixed_vector& rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+  }
+private:
+  alignas(T) std::array<std::byte, sizeof(T) * N> m_buf;
+  std::size_t m_size {0u};
+};
+
+template <typename T, std::size_t N>
+class small_vector {
+public:
+  using value_type = T;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  small_vector() = default;
+  small_vector(std::initializer_list<T> il) { append(std::span<const T>(il.begin(), il.size())); }
+  small_vector(const small_vector& other) { append(other.span()); }
+  small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) { take(other); }
+  small_vector& operator= (const small_vector& other) {
+    if (this != &other) {
+      clear();
+      append(other.span());
+    }
+    return *this;
+  }
+  small_vector& operator= (small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    if (this != &other) {
+      release();
+      take(other);
+    }
+    return *this;
+  }
+  ~small_vector() { release(); }
+
+  template <typename... Args>
+  T& emplace_back (Args&&... args) {
+    if (m_size == m_cap) { // build the new element first, args may refer to an element
+      auto new_cap = std::max<std::size_t>(2u * m_cap, 1u);
+      T* p = std::allocator<T>{}.allocate(new_cap);
+      try {
+        std::construct_at(p + m_size, std::forward<Args>(args)...);
+      }
+      catch (...) {
+        std::allocator<T>{}.deallocate(p, new_cap);
+        throw;
+      }
+      vec_core::relocate_n(m_data, m_size, p);
+      adopt(p, new_cap);
+    }
+    else {
+      std::construct_at(m_data + m_size, std::forward<Args>(args)...);
+    }
+    return m_data[m_size++];
+  }
+  void push_back (const T& val) { emplace_back(val); }
+  void push_back (T&& val) { emplace_back(std::move(val)); }
+  void append (std::span<const T> vals) {
+    if ((m_size + vals.size()) > m_cap) { // as in emplace_back, vals may be this vector's elements
+      auto new_cap = std::max(2u * m_cap, m_size + vals.size());
+      T* p = std::allocator<T>{}.allocate(new_cap);
+      try {
+        vec_core::copy_construct_n(vals.data(), vals.size(), p + m_size);
+      }
+      catch (...) {
+        std::allocator<T>{}.deallocate(p, new_cap);
+        throw;
+      }
+      vec_core::relocate_n(m_data, m_size, p);
+      adopt(p, new_cap);
+    }
+    else {
+      vec_core::copy_construct_n(vals.data(), vals.size(), m_data + m_size);
+    }
+    m_size += vals.size();
+  }
+  iterator insert (const_iterator pos, T val) { // val is a copy, so growing cannot invalidate it
+    auto idx = static_cast<std::size_t>(pos - m_data);
+    if (m_size == m_cap) { reserve(2u * m_cap + 1u); }
+    vec_core::insert_at(m_data, m_size, idx, std::move(val));
+    return m_data + idx;
+  }
+  iterator erase (const_iterator pos) {
+    auto idx = static_cast<std::size_t>(pos - m_data);
+    vec_core::erase_at(m_data, m_size, idx);
+    return m_data + idx;
+  }
+  void reserve (std::size_t new_cap) {
+    if (new_cap <= m_cap) { return; }
+    T* p = std::allocator<T>{}.allocate(new_cap);
+    vec_core::relocate_n(m_data, m_size, p);
+    adopt(p, new_cap);
+  }
+  void pop_back () { std::destroy_at(m_data + m_size - 1u); --m_size; }
+  void clear () noexcept { std::destroy_n(m_data, m_size); m_size = 0u; }
+
+  T* data () noexcept { return m_data; }
+  const T* data () const noexcept { return m_data; }
+  std::span<const T> span () const noexcept { return std::span<const T>(m_data, m_size); }
+  T& operator[] (std::size_t i) noexcept { return m_data[i]; }
+  const T& operator[] (std::size_t i) const noexcept { return m_data[i]; }
+  iterator begin () noexcept { return m_data; }
+  iterator end () noexcept { return m_data + m_size; }
+  const_iterator begin () const noexcept { return m_data; }
+  const_iterator end () const noexcept { return m_data + m_size; }
+  std::size_t size () const noexcept { return m_size; }
+  bool empty () const noexcept { return m_size == 0u; }
+  std::size_t capacity () const noexcept { return m_cap; }
+  bool is_inline () const noexcept { return m_data == inline_data(); }
+
+  friend bool operator== (const small_vector& lhs, const small_vector& rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+  }
+private:
+  T* inline_data () noexcept { return std::launder(reinterpret_cast<T*>(m_buf.data())); }
+  const T* inline_data () const noexcept { return std::launder(reinterpret_cast<const T*>(m_buf.data())); }
+
+  // elements have already been moved to p
+  void adopt (T* p, std::size_t new_cap) noexcept {
+    if (!is_inline()) { std::allocator<T>{}.deallocate(m_data, m_cap); }
+    m_data = p;
+    m_cap = new_cap;
+  }
+  void release () noexcept {
+    clear();
+    if (!is_inline()) { std::allocator<T>{}.deallocate(m_data, m_cap); }
+    m_data = inline_data();
+    m_cap = N;
+  }
+  // this is empty and inline; heap storage is stolen, inline elements are moved
+  void take (small_vector& other) {
+    if (other.is_inline()) {
+      vec_core::relocate_n(other.m_data, other.m_size, m_data);
+    }
+    else {
+      m_data = std::exchange(other.m_data, other.inline_data());
+      m_cap = std::exchange(other.m_cap, N);
+    }
+    m_size = std::exchange(other.m_size, 0u);
+  }
+
+  alignas(T) std::array<std::byte, sizeof(T) * N> m_buf;
+  T* m_data { inline_data() };
+  std::size_t m_size {0u};
+  std::size_t m_cap {N};
+};
+
+// counts live objects, to check that every element constructed is destroyed
+struct tracked {
+  inline static int live {0};
+  std::string val;
+  tracked(std::string v) : val(std::move(v)) { ++live; }
+  tracked(const tracked& o) : val(o.val) { ++live; }
+  tracked(tracked&& o) noexcept : val(std::move(o.val)) { ++live; }
+  tracked& operator= (const tracked&) = default;
+  tracked& operator= (tracked&&) = default;
+  ~tracked() { --live; }
+  friend bool operator== (const tracked&, const tracked&) = default;
+};
+
+template <typename Vec>
+std::vector<std::string> vals_of (const Vec& v) {
+  std::vector<std::string> out;
+  for (const auto& e : v) { out.push_back(e.val); }
+  return out;
+}
+
+TEST_CASE( "fixed_vector", "[fixed_vector]" ) {
+
+  SECTION( "Trivially copyable elements" ) {
+    fixed_vector<int, 4> v { 10, 20 };
+    v.push_back(40);
+    v.insert(v.begin() + 2, 30);
+    REQUIRE( v == fixed_vector<int, 4>{ 10, 20, 30, 40 } );
+    REQUIRE_THROWS_AS( v.push_back(50), std::range_error );
+    v.erase(v.begin());
+    REQUIRE( v == fixed_vector<int, 4>{ 20, 30, 40 } );
+    auto w = v;
+    auto x = std::move(w);
+    REQUIRE( x == v );
+    REQUIRE( w.empty() );
+    REQUIRE_THROWS_AS( (fixed_vector<int, 1>{ 1, 2 }), std::range_error );
+    fixed_vector<int, 0> z;
+    REQUIRE_THROWS( z.push_back(1) );
+  }
+
+  SECTION( "Elements with ctors and dtors" ) {
+    {
+      fixed_vector<tracked, 5> v;
+      v.emplace_back("b");
+      v.emplace_back("d");
+      v.insert(v.begin(), tracked("a"));
+      v.insert(v.begin() + 2, tracked("c"));
+      v.insert(v.end(), tracked("e"));
+      REQUIRE( vals_of(v) == std::vector<std::string>{ "a", "b", "c", "d", "e" } );
+      REQUIRE( tracked::live == 5 );
+      v.erase(v.begin() + 1);
+      REQUIRE( vals_of(v) == std::vector<std::string>{ "a", "c", "d", "e" } );
+      REQUIRE( tracked::live == 4 );
+      auto w = v;
+      REQUIRE( tracked::live == 8 );
+      fixed_vector<tracked, 5> x;
+      x = std::move(w);
+      REQUIRE( tracked::live == 8 ); // elements moved, originals destroyed
+      REQUIRE( x == v );
+      v.pop_back();
+      REQUIRE( tracked::live == 7 );
+    }
+    REQUIRE( tracked::live == 0 );
+  }
+}
+
+TEST_CASE( "small_vector", "[small_vector]" ) {
+
+  SECTION( "Stays inline, then spills to the heap" ) {
+    small_vector<int, 4> v { 1, 2, 3 };
+    REQUIRE( v.is_inline() );
+    v.push_back(4);
+    REQUIRE( v.is_inline() );
+    v.push_back(v[0]); // reference to an element while growing
+    REQUIRE( !v.is_inline() );
+    REQUIRE( v == small_vector<int, 4>{ 1, 2, 3, 4, 1 } );
+    v.insert(v.begin(), v[4]);
+    v.erase(v.end() - 1);
+    REQUIRE( v == small_vector<int, 4>{ 1, 1, 2, 3, 4 } );
+    auto w = std::move(v); // heap storage is taken over
+    REQUIRE( !w.is_inline() );
+    REQUIRE( v.is_inline() );
+    REQUIRE( v.empty() );
+    small_vector<int, 0> z;
+    z.push_back(7);
+    REQUIRE( z[0] == 7 );
+  }
+
+  SECTION( "Appending grows geometrically, and may append its own elements" ) {
+    small_vector<int, 2> v;
+    int regrows {0};
+    for (int i {0}; i < 1'000; ++i) {
+      auto cap = v.capacity();
+      v.append(std::span<const int>(&i, 1u));
+      regrows += (v.capacity() != cap) ? 1 : 0;
+    }
+    REQUIRE( regrows <= 10 );
+    small_vector<int, 4> w { 1, 2, 3 };
+    w.append(w.span()); // spills to the heap while reading the inline elements
+    REQUIRE( w == small_vector<int, 4>{ 1, 2, 3, 1, 2, 3 } );
+    w.append(w.span());
+    REQUIRE( w.size() == 12u );
+    REQUIRE( w[11] == 3 );
+    {
+      small_vector<tracked, 2> t;
+      t.emplace_back("a");
+      t.emplace_back("b");
+      t.append(t.span());
+      REQUIRE( vals_of(t) == std::vector<std::string>{ "a", "b", "a", "b" } );
+      REQUIRE( tracked::live == 4 );
+    }
+    REQUIRE( tracked::live == 0 );
+  }
+
+  SECTION( "Elements with ctors and dtors" ) {
+    {
+      small_vector<tracked, 2> v;
+      v.emplace_back("a");
+      v.emplace_back("b");
+      v.emplace_back("c");
+      v.insert(v.begin() + 1, tracked("x"));
+      REQUIRE( vals_of(v) == std::vector<std::string>{ "a", "x", "b", "c" } );
+      REQUIRE( tracked::live == 4 );
+      small_vector<tracked, 2> inl;
+      inl.emplace_back("i");
+      auto w = inl;
+      auto y = v;
+      REQUIRE( tracked::live == 10 );
+      w = std::move(y); // w drops its element and takes y's heap storage
+      REQUIRE( tracked::live == 9 );
+      REQUIRE( w == v );
+      REQUIRE( y.empty() );
+      y = std::move(inl); // inline elements are moved, originals destroyed
+      REQUIRE( vals_of(y) == std::vector<std::string>{ "i" } );
+      REQUIRE( inl.empty() );
+      REQUIRE( tracked::live == 9 );
+    }
+    REQUIRE( tracked::live == 0 );
+  }
+}
+
+////////////////////
+// Beyond the slides - scoped tracing
+//
+// The example programs are instrumented with TRACE_SCOPE (from scoped_trace.hpp in
+// the common directory), which is compiled in only with SCOPED_TRACE_ENABLED. The
+// scoped_trace classes underneath are always available, so they are tested here
+// directly; the trace file a test run writes is not checked by the unit tests.
+////////////////////
+
+std::size_t count_substr (const std::string& str, std::string_view sub) {
+  std::size_t cnt {0u};
+  for (auto pos = str.find(sub); pos != std::string::npos; pos = str.find(sub, pos + sub.size())) {
+    ++cnt;
+  }
+  return cnt;
+}
+
+TEST_CASE( "scoped_trace events and Chrome trace export", "[scoped_trace]" ) {
+  auto trace_str = [] {
+    std::ostringstream os;
+    scoped_trace::write_chrome_trace(os);
+    return os.str();
+  };
+  std::string before = trace_str();
+  {
+    scoped_trace::scope outer { "trace \"test\" outer" };
+    std::thread thr ([] {
+      for (int i {0}; i < 3; ++i) {
+        scoped_trace::scope inner { "trace test thread" };
+      }
+    } );
+    thr.join();
+  }
+  std::string after = trace_str();
+
+  REQUIRE( after.starts_with("{\"traceEvents\":[") );
+  REQUIRE( after.ends_with("}}\n") );
+  REQUIRE( count_substr(after, "\"ph\":\"X\"") == count_substr(before, "\"ph\":\"X\"") + 4u );
+  REQUIRE( count_substr(after, "\"name\":\"trace test thread\"") ==
+           count_substr(before, "\"name\":\"trace test thread\"") + 3u );
+  REQUIRE( count_substr(after, R"("name":"trace \"test\" outer")") == 1u ); // escaped
+  REQUIRE( count_substr(after, "\"dropped_events\":0}") == 1u );
+
+  std::ostringstream os;
+  os << 1.5;
+  REQUIRE( os.str() == "1.5" ); // stream formatting is put back
+  scoped_trace::write_chrome_trace(os);
+  os.str("");
+  os << 1.5;
+  REQUIRE( os.str() == "1.5" );
+}
+
+// hidden benchmark, run with: unit_test_with_catch2_test "[benchmark]"
+template <typename S>
+std::vector<S> gen_short_keys (std::size_t n) {
+  std::vector<S> keys;
+  for (std::size_t i {0}; i < n; ++i) {
+    auto str = "key_" + std::to_string(i * 2'654'435'761u % 1'000'003u); // up to 11 chars
+    keys.push_back(S(str));
+  }
+  return keys;
+}
+
+TEST_CASE( "f_str lookup benchmark", "[.][benchmark][f_str]" ) {
+  constexpr std::size_t num_keys { 100'000u };
+  auto str_keys = gen_short_keys<std::string>(num_keys);
+  auto f_keys = gen_short_keys<f_str<16>>(num_keys);
+  std::unordered_set<std::string> str_set (str_keys.begin(), str_keys.end());
+  std::unordered_set<f_str<16>> f_set (f_keys.begin(), f_keys.end());
+  auto sorted_str = str_keys;
+  std::sort(sorted_str.begin(), sorted_str.end());
+  auto sorted_f = f_keys;
+  std::sort(sorted_f.begin(), sorted_f.end());
+
+  BENCHMARK( "unordered_set<std::string> find, 100K short keys" ) {
+    std::size_t found {0};
+    for (const auto& k : str_keys) { found += str_set.count(k); }
+    return found;
+  };
+  BENCHMARK( "unordered_set<f_str<16>> find, 100K short keys" ) {
+    std::size_t found {0};
+    for (const auto& k : f_keys) { found += f_set.count(k); }
+    return found;
+  };
+  BENCHMARK( "binary search std::string, 100K short keys" ) {
+    std::size_t found {0};
+    for (const auto& k : str_keys) { found += std::binary_search(sorted_str.begin(), sorted_str.end(), k); }
+    return found;
+  };
+  BENCHMARK( "f_str<32> construct and append, 100K short keys" ) {
+    std::size_t total {0};
+    for (const auto& k : str_keys) {
+      f_str<32> f(k);
+      f.append(k);
+      total += f.size();
+    }
+    return total;
+  };
+  BENCHMARK( "binary search f_str<16>, 100K short keys" ) {
+    std::size_t found {0};
+    for (const auto& k : f_keys) { found += std::binary_search(sorted_f.begin(), sorted_f.end(), k); }
+    return found;
+  };
+}
+
+TEST_CASE( "f_str_map benchmark", "[.][benchmark][f_str_map]" ) {
+  constexpr std::size_t num_keys { 100'000u };
+  auto str_keys = gen_short_keys<std::string>(num_keys);
+  auto f_keys = gen_short_keys<f_str<16>>(num_keys);
+
+  BENCHMARK( "unordered_map<std::string, int> insert, 100K short keys" ) {
+    std::unordered_map<std::string, int> m;
+    for (const auto& k : str_keys) { m.emplace(k, 1); }
+    return m.size();
+  };
+  BENCHMARK( "f_str_map<16, int> insert, 100K short keys" ) {
+    f_str_map<16, int> m;
+    for (const auto& k : f_keys) { m.insert(k, 1); }
+    return m.size();
+  };
+
+  std::unordered_map<std::string, int> str_map;
+  f_str_map<16, int> f_map;
+  for (std::size_t i {0}; i < num_keys; i += 2u) { // half of the lookups miss
+    str_map.emplace(str_keys[i], 1);
+    f_map.insert(f_keys[i], 1);
+  }
+  BENCHMARK( "unordered_map<std::string, int> find, 100K short keys" ) {
+    std::size_t found {0};
+    for (const auto& k : str_keys) { found += str_map.count(k); }
+    return found;
+  };
+  BENCHMARK( "f_str_map<16, int> find, 100K short keys" ) {
+    std::size_t found {0};
+    for (const auto& k : f_keys) { found += f_map.contains(k); }
+    return found;
+  };
+}
+
+TEST_CASE( "fixed_vector, small_vector benchmark", "[.][benchmark][fixed_vector][small_vector]" ) {
+  constexpr int num_lists { 100'000 };
+
+  BENCHMARK( "std::vector<int>, 100K lists of 6" ) {
+    std::size_t total {0};
+    for (int i {0}; i < num_lists; ++i) {
+      std::vector<int> v;
+      for (int j {0}; j < 6; ++j) { v.push_back(i + j); }
+      total += v.size();
+    }
+    return total;
+  };
+  BENCHMARK( "small_vector<int, 8>, 100K lists of 6" ) {
+    std::size_t total {0};
+    for (int i {0}; i < num_lists; ++i) {
+      small_vector<int, 8> v;
+      for (int j {0}; j < 6; ++j) { v.push_back(i + j); }
+      total += v.size();
+    }
+    return total;
+  };
+  BENCHMARK( "fixed_vector<int, 8>, 100K lists of 6" ) {
+    std::size_t total {0};
+    for (int i {0}; i < num_lists; ++i) {
+      fixed_vector<int, 8> v;
+      for (int j {0}; j < 6; ++j) { v.push_back(i + j); }
+      total += v.size();
+    }
+    return total;
+  };
+}
+
+TEMPLATE_TEST_CASE( "batch square, add_sub_div benchmark", "[.][benchmark][batch]", int, float, double ) {
+  constexpr std::size_t num_vals { 16'384u }; // 3 arrays fit in L2, so the ISA level shows, not memory bandwidth
+  auto a = gen_batch_vals<TestType>(num_vals, 37u, 0);
+  auto b = gen_batch_vals<TestType>(num_vals, 37u, 2'002);
+  std::vector<TestType> out(num_vals);
+
+  BENCHMARK( "scalar square loop, 16K" ) {
+    for (std::size_t i {0}; i < num_vals; ++i) { out[i] = static_cast<TestType>(square(a[i])); }
+    return out[0];
+  };
+  for (std::size_t l {0}; l <= static_cast<std::size_t>(isa::detected()); ++l) {
+    isa::force_guard guard { static_cast<isa::level>(l) };
+    BENCHMARK( "batch square, 16K, " + std::string(isa::name(isa::active())) ) {
+      batch::square<TestType>(a, out);
+      return out[0];
+    };
+    BENCHMARK( "batch add_sub_div, 16K, " + std::string(isa::name(isa::active())) ) {
+      batch::add_sub_div<TestType>(a, b, out);
+      return out[0];
+    };
+  }
+}
+
+TEST_CASE( "factorial, binomial table benchmark", "[.][benchmark][comb]" ) {
+  constexpr std::uint32_t num_calls { 1'000'000u };
+
+  BENCHMARK( "recursive factorial, 1M calls" ) {
+    std::uint64_t sum {0};
+    for (std::uint32_t i {0}; i < num_calls; ++i) { sum += factorial(i % 13u); }
+    return sum;
+  };
+  BENCHMARK( "comb::factorial table lookup, 1M calls" ) {
+    std::uint64_t sum {0};
+    for (std::uint32_t i {0}; i < num_calls; ++i) { sum += comb::factorial<std::uint32_t>(i % 13u); }
+    return sum;
+  };
+  BENCHMARK( "binomial by multiplicative loop, 1M calls" ) {
+    std::uint64_t sum {0};
+    for (std::uint32_t i {0}; i < num_calls; ++i) {
+      std::uint64_t n = i % 60u;
+      std::uint64_t k = (i / 60u) % (n + 1u);
+      std::uint64_t c {1};
+      for (std::uint64_t j {1}; j <= std::min(k, n - k); ++j) { c = c * (n - std::min(k, n - k) + j) / j; }
+      sum += c;
+    }
+    return sum;
+  };
+  BENCHMARK( "comb::binomial table lookup, 1M calls" ) {
+    std::uint64_t sum {0};
+    for (std::uint32_t i {0}; i < num_calls; ++i) {
+      std::uint64_t n = i % 60u;
+      sum += comb::binomial(n, (i / 60u) % (n + 1u));
+    }
+    return sum;
+  };
+  BENCHMARK( "comb::big_factorial(1000)" ) {
+    return comb::big_factorial(1'000u);
+  };
+}
+
+TEST_CASE( "scoped_trace overhead benchmark", "[.][benchmark][scoped_trace]" ) {
+  BENCHMARK( "scoped_trace::ticks" ) {
+    return scoped_trace::ticks();
+  };
+  // each sample runs on a new thread, which starts with an empty buffer, so the events
+  // are kept rather than dropped once a thread's maximum is reached
+  BENCHMARK_ADVANCED( "scoped_trace::scope" )(Catch::Benchmark::Chronometer meter) {
+    std::thread thr ([&meter] {
+      meter.measure([] {
+        scoped_trace::scope sc { "benchmark scope" };
+        return 0;
+      } );
+    } );
+    thr.join();
+  };
+  BENCHMARK( "TRACE_SCOPE (nothing unless SCOPED_TRACE_ENABLED)" ) {
+    TRACE_SCOPE("benchmark TRACE_SCOPE");
+    return 0;
+  };
+}